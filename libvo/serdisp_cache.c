@@ -0,0 +1,273 @@
+/*
+ * MPlayer
+ *
+ * playback cache for the video driver for serdisplib (vo_serdisp.c, option 'cache')
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "config.h"
+#if HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+#include "serdisp_cache.h"
+#include "mp_msg.h"
+
+
+/* *********************************
+   sd_cachemap(c, key)
+   *********************************
+   maps the playback cache into memory for replaying it if it matches the key
+   *********************************
+   c      ... playback cache (name, rowbytes and height set)
+   key    ... key of the current display and flags
+   *********************************
+   returns 0 if the cache is replayed, -1 if it doesn't exist or doesn't match
+   *********************************
+   --
+*/
+int sd_cachemap(sd_cache_t* c, const char* key) {
+#if HAVE_SYS_MMAN_H
+  const unsigned char* data;
+  struct stat st;
+  size_t keylen = strlen(key);
+  uint32_t hdr[3];
+  int fd;
+
+  if ((fd = open(c->name, O_RDONLY)) < 0)
+    return -1;
+  if (fstat(fd, &st) || st.st_size < 8 + sizeof(hdr) + keylen ||
+      (data = (const unsigned char*)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED) {
+    close(fd);
+    return -1;
+  }
+  close(fd);
+
+  /* header: magic, key length, row length, key */
+  memcpy(hdr, data + 8, sizeof(hdr));
+  if (memcmp(data, SD_CACHE_MAGIC, 8) || hdr[0] != keylen || hdr[1] != c->rowbytes || hdr[2] != c->height ||
+      memcmp(data + 8 + sizeof(hdr), key, keylen)) {
+    mp_msg(MSGT_VO, MSGL_INFO, "vo_serdisp: cache %s doesn't match display or flags, recording\n", c->name);
+    munmap((void*)data, st.st_size);
+    return -1;
+  }
+  if (!(c->prev = (unsigned char*)malloc(c->rowbytes * c->height))) {
+    munmap((void*)data, st.st_size);
+    return -1;
+  }
+
+  c->data = data;
+  c->size = st.st_size;
+  c->pos = 8 + sizeof(hdr) + keylen;
+  c->started = 0;
+  return 0;
+#else
+  return -1;
+#endif
+}
+
+
+/* *********************************
+   sd_cacheopen(c, key) / sd_cacheclose(c, keep)
+   *********************************
+   starts recording the playback cache into <name>.tmp /
+   stops recording / replaying. the cache recorded is only renamed to <name> if frames have been recorded
+   *********************************
+   c      ... playback cache (name, rowbytes and height set)
+   key    ... key of the current display and flags
+   keep   ... recording complete (0: the cache recorded is discarded)
+   *********************************
+   sd_cacheopen() returns 0 if ok, else -1
+   sd_cacheclose() returns 1 if a cache has been recorded, else 0
+   *********************************
+   --
+*/
+int sd_cacheopen(sd_cache_t* c, const char* key) {
+  char tmpname[PATH_MAX];
+  uint32_t hdr[3];
+
+  snprintf(tmpname, sizeof(tmpname), "%s.tmp", c->name);
+  c->prev = (unsigned char*)malloc(c->rowbytes * c->height);
+  c->rec = (unsigned char*)malloc((c->rowbytes + 4) * c->height);
+  if (!c->prev || !c->rec || !(c->file = fopen(tmpname, "wb")))
+    return -1;
+
+  hdr[0] = strlen(key);
+  hdr[1] = c->rowbytes;
+  hdr[2] = c->height;
+  fwrite(SD_CACHE_MAGIC, 1, 8, c->file);
+  fwrite(hdr, sizeof(hdr), 1, c->file);
+  fwrite(key, 1, hdr[0], c->file);
+  c->started = 0;
+  return 0;
+}
+
+int sd_cacheclose(sd_cache_t* c, int keep) {
+  char tmpname[PATH_MAX];
+  int recorded = 0;
+
+  if (c->file) {
+    snprintf(tmpname, sizeof(tmpname), "%s.tmp", c->name);
+    if (fclose(c->file) || !keep || !c->started || rename(tmpname, c->name))
+      unlink(tmpname);
+    else
+      recorded = 1;
+    c->file = NULL;
+  }
+#if HAVE_SYS_MMAN_H
+  if (c->data) {
+    munmap((void*)c->data, c->size);
+    c->data = NULL;
+  }
+#endif
+  if (c->prev) {
+    free(c->prev);
+    c->prev = NULL;
+  }
+  if (c->rec) {
+    free(c->rec);
+    c->rec = NULL;
+  }
+  c->started = 0;
+  return recorded;
+}
+
+
+/* *********************************
+   sd_cacheconfig(c, flip, geometry, size, frame)
+   *********************************
+   recording: records the geometry set by config() (display content has been reset to background) /
+   replay: checks the next record against the geometry and skips it if it matches
+   *********************************
+   c        ... playback cache
+   flip     ... flip_page() calls before config()
+   geometry ... geometry of the video (source, scaled frame, screen area, rotation)
+   size     ... bytes of geometry
+   frame    ... display content after config() (greyscale/monochrome: packed frame buffer, truecolour: staging buffer)
+   *********************************
+   returns 0 if ok, -1 if the cache replayed doesn't match the geometry
+   *********************************
+   --
+*/
+int sd_cacheconfig(sd_cache_t* c, uint32_t flip, const int32_t* geometry, int size, const unsigned char* frame) {
+  cache_rec_t rec;
+
+  if (c->data) {
+    if (c->pos + sizeof(rec) + size > c->size)
+      return -1;
+    memcpy(&rec, c->data + c->pos, sizeof(rec));
+    if (rec.type != SD_CACHE_CONFIG || rec.size != size || memcmp(c->data + c->pos + sizeof(rec), geometry, size))
+      return -1;
+    c->pos += sizeof(rec) + rec.size;
+    memcpy(c->prev, frame, c->rowbytes * c->height);
+    return 0;
+  }
+  if (!c->file)
+    return 0;
+
+  memcpy(c->prev, frame, c->rowbytes * c->height);
+  rec.type = SD_CACHE_CONFIG;
+  rec.frame = flip;
+  rec.size = size;
+  fwrite(&rec, sizeof(rec), 1, c->file);
+  fwrite(geometry, size, 1, c->file);
+  return 0;
+}
+
+
+/* *********************************
+   sd_cachereplay(c, flip)
+   *********************************
+   applies the frame records of the playback cache up to the current flip_page() call to the frame replayed (prev)
+   *********************************
+   c      ... playback cache (replay)
+   flip   ... flip_page() calls before the current one
+   *********************************
+   returns 1 if the frame replayed has been changed, 0 if no frame has been recorded for this call,
+   -1 if the cache is exhausted or doesn't match the video (a config() record is due)
+   *********************************
+   --
+*/
+int sd_cachereplay(sd_cache_t* c, uint32_t flip) {
+  int changed = 0;
+
+  while (c->pos + sizeof(cache_rec_t) <= c->size) {
+    cache_rec_t rec;
+    const unsigned char* p;
+    const unsigned char* end;
+    uint16_t run[2];
+
+    memcpy(&rec, c->data + c->pos, sizeof(rec));
+    if (rec.size > c->size - c->pos - sizeof(rec))   /* recording has been interrupted */
+      break;
+    if (rec.type == SD_CACHE_CONFIG || rec.frame > flip)
+      return (changed || rec.type != SD_CACHE_CONFIG) ? changed : -1;
+
+    p = c->data + c->pos + sizeof(rec);
+    end = p + rec.size;
+    c->pos += sizeof(rec) + rec.size;
+    if (rec.type != SD_CACHE_FRAME)
+      continue;
+    while (p + sizeof(run) <= end) {
+      memcpy(run, p, sizeof(run));
+      p += sizeof(run);
+      if (run[0] + run[1] > c->height || p + run[1] * c->rowbytes > end)
+        break;
+      memcpy(c->prev + run[0] * c->rowbytes, p, run[1] * c->rowbytes);
+      p += run[1] * c->rowbytes;
+    }
+    changed = 1;
+    c->started = 1;
+  }
+  return (changed) ? 1 : -1;
+}
+
+
+/* *********************************
+   sd_cacheframe(c, flip, buf)
+   *********************************
+   records the runs of rows of a frame changed since the last frame recorded
+   *********************************
+   c      ... playback cache (recording)
+   flip   ... flip_page() calls before the current one
+   buf    ... frame (greyscale/monochrome: packed frame buffer, truecolour: staging buffer)
+   *********************************
+   --
+*/
+void sd_cacheframe(sd_cache_t* c, uint32_t flip, const unsigned char* buf) {
+  cache_rec_t rec;
+  unsigned char* p = c->rec;
+  int rowbytes = c->rowbytes;
+  uint16_t run[2];
+  int y, n;
+
+  c->started = 1;
+  for (y = 0; y < c->height; y += n) {
+    for (n = 0; y + n < c->height && memcmp(buf + (y + n) * rowbytes, c->prev + (y + n) * rowbytes, rowbytes); n++)
+      ;
+    if (!n) {
+      n = 1;
+      continue;
+    }
+    run[0] = y;
+    run[1] = n;
+    memcpy(p, run, sizeof(run));
+    memcpy(p + sizeof(run), buf + y * rowbytes, n * rowbytes);
+    memcpy(c->prev + y * rowbytes, buf + y * rowbytes, n * rowbytes);
+    p += sizeof(run) + n * rowbytes;
+  }
+
+  rec.type = SD_CACHE_FRAME;
+  rec.frame = flip;
+  rec.size = p - c->rec;
+  fwrite(&rec, sizeof(rec), 1, c->file);
+  fwrite(c->rec, 1, rec.size, c->file);
+}
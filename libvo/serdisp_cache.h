@@ -0,0 +1,48 @@
+/*
+ * MPlayer
+ *
+ * playback cache for the video driver for serdisplib (vo_serdisp.c, option 'cache'):
+ * frames as output are recorded into a file (delta encoded) and replayed instead of being drawn
+ *
+ */
+
+#ifndef MPLAYER_SERDISP_CACHE_H
+#define MPLAYER_SERDISP_CACHE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* the file starts with SD_CACHE_MAGIC, the key length, the row length, the rows per frame and the key identifying
+   display, flags and equalizer values. it is followed by records: config() (geometry, display content reset to
+   background) and frames (runs of rows changed since the last frame) */
+#define SD_CACHE_MAGIC   "SDCACHE2"
+#define SD_CACHE_CONFIG  1                        /* record: config() (geometry), display content reset to background */
+#define SD_CACHE_FRAME   2                        /* record: frame (runs: uint16_t first row, uint16_t rows, row data) */
+
+typedef struct {
+  uint32_t type;
+  uint32_t frame;                                 /* flip_page() calls before the record */
+  uint32_t size;                                  /* bytes following */
+} cache_rec_t;
+
+typedef struct {
+  char*                name;                      /* cache file (recorded into <name>.tmp, renamed by sd_cacheclose()) */
+  int                  rowbytes;                  /* bytes per row of the frames */
+  int                  height;                    /* rows per frame */
+  FILE*                file;                      /* recording */
+  const unsigned char* data;                      /* replay: cache mapped into memory */
+  size_t               size, pos;                 /* replay: size of the cache / position of the next record */
+  unsigned char*       prev;                      /* recording: last frame recorded, replay: frame replayed */
+  unsigned char*       rec;                       /* frame record being built */
+  int                  started;                   /* a frame has been recorded / replayed */
+} sd_cache_t;
+
+int  sd_cachemap(sd_cache_t* c, const char* key);
+int  sd_cacheopen(sd_cache_t* c, const char* key);
+int  sd_cacheclose(sd_cache_t* c, int keep);
+int  sd_cacheconfig(sd_cache_t* c, uint32_t flip, const int32_t* geometry, int size, const unsigned char* frame);
+int  sd_cachereplay(sd_cache_t* c, uint32_t flip);
+void sd_cacheframe(sd_cache_t* c, uint32_t flip, const unsigned char* buf);
+
+#endif /* MPLAYER_SERDISP_CACHE_H */
@@ -0,0 +1,129 @@
+/*
+ * MPlayer
+ *
+ * frame export for the video driver for serdisplib (vo_serdisp.c, option 'shm')
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include "config.h"
+#if HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+#include "serdisp_export.h"
+#include "osdep/timer.h"
+
+
+/* *********************************
+   sd_exportopen(ex, width, height, depth, colours, stride, slots) / sd_exportclose(ex)
+   *********************************
+   creates and maps the shared memory object of the frame export (an existing object is replaced,
+   consumers still mapping it keep the old one) / marks the export inactive and removes the object
+   *********************************
+   ex       ... frame export (name: name of the shared memory object)
+   width    ... frame geometry (display orientation)
+   height
+   depth    ... bits per pixel of the frames (see export_header_t)
+   colours  ... number of colours
+   stride   ... bytes per row of the frames
+   slots    ... number of slots in the ring buffer (limited to [2, SD_SHM_MAXSLOTS])
+   *********************************
+   sd_exportopen() returns 0 if successful, else -1
+   *********************************
+   --
+*/
+int sd_exportopen(sd_export_t* ex, int width, int height, int depth, int colours, int stride, int slots) {
+#if HAVE_SYS_MMAN_H
+  size_t headersize = (sizeof(export_header_t) + 63) & ~63;
+  size_t slotsize = (sizeof(export_slot_t) + stride * height + 63) & ~63;
+  export_header_t* hdr;
+  void* mem;
+  int fd;
+
+  if (slots < 2)
+    slots = 2;
+  if (slots > SD_SHM_MAXSLOTS)
+    slots = SD_SHM_MAXSLOTS;
+  ex->size = headersize + slots * slotsize;
+
+  shm_unlink(ex->name);
+  if ((fd = shm_open(ex->name, O_CREAT | O_EXCL | O_RDWR, 0644)) < 0)
+    return -1;
+  if (ftruncate(fd, ex->size) ||
+      (mem = mmap(NULL, ex->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+    close(fd);
+    shm_unlink(ex->name);
+    return -1;
+  }
+  close(fd);
+
+  /* the object is zero-filled: no slot is valid yet */
+  hdr = (export_header_t*)mem;
+  hdr->headersize = headersize;
+  hdr->slots = slots;
+  hdr->slotsize = slotsize;
+  hdr->width = width;
+  hdr->height = height;
+  hdr->depth = depth;
+  hdr->colours = colours;
+  hdr->stride = stride;
+  hdr->pid = getpid();
+  hdr->active = 1;
+  __sync_synchronize();
+  memcpy(hdr->magic, SD_SHM_MAGIC, 8);
+  ex->hdr = hdr;
+  ex->t0 = 0;
+  return 0;
+#else
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
+void sd_exportclose(sd_export_t* ex) {
+#if HAVE_SYS_MMAN_H
+  if (ex->hdr) {
+    ex->hdr->active = 0;
+    munmap((void*)ex->hdr, ex->size);
+    shm_unlink(ex->name);
+    ex->hdr = NULL;
+  }
+#endif
+}
+
+
+/* *********************************
+   sd_exportframe(ex, buf)
+   *********************************
+   publishes a frame in the next slot of the ring buffer. the slot's sequence number is 0 while it is written,
+   so consumers detect frames that have been overwritten while reading them in place
+   *********************************
+   ex     ... frame export
+   buf    ... frame (greyscale/monochrome: packed frame buffer, truecolour: staging buffer)
+   *********************************
+   --
+*/
+void sd_exportframe(sd_export_t* ex, const unsigned char* buf) {
+  uint32_t seq = ex->hdr->seq + 1;
+  export_slot_t* slot;
+
+  if (!ex->hdr->seq)
+    ex->t0 = GetTimer();
+  if (!seq)   /* wrap-around: 0 is reserved */
+    seq = 1;
+  slot = (export_slot_t*)((unsigned char*)ex->hdr + ex->hdr->headersize + (seq % ex->hdr->slots) * ex->hdr->slotsize);
+
+  slot->seq = 0;
+  __sync_synchronize();
+  memcpy(slot + 1, buf, ex->hdr->stride * ex->hdr->height);
+  slot->time = (GetTimer() - ex->t0) / 1000000.0;
+  __sync_synchronize();
+  slot->seq = seq;
+  ex->hdr->seq = seq;
+}
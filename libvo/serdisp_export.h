@@ -0,0 +1,53 @@
+/*
+ * MPlayer
+ *
+ * frame export for the video driver for serdisplib (vo_serdisp.c, option 'shm'):
+ * frames as output are published into a ring buffer in a POSIX shared memory object
+ *
+ */
+
+#ifndef MPLAYER_SERDISP_EXPORT_H
+#define MPLAYER_SERDISP_EXPORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* complete frames as drawn (packed frame buffer / staging buffer, without OSD) are published into a ring of slots
+   in a POSIX shared memory object. a slot is only overwritten <slots> frames later, so consumers read frames in place.
+   header and slots are laid out as described in README.md */
+#define SD_SHM_MAGIC     "SDSHM001"
+#define SD_SHM_MAXSLOTS  64
+
+typedef struct {
+  char              magic[8];                     /* SD_SHM_MAGIC (written once the header is complete) */
+  uint32_t          headersize;                   /* offset of the first slot */
+  uint32_t          slots;                        /* number of slots */
+  uint32_t          slotsize;                     /* bytes per slot (slot header and frame) */
+  uint32_t          width, height;                /* frame geometry (display orientation) */
+  uint32_t          depth;                        /* bits per pixel: 1/2/4/8: colour indices (packed, msb first),
+                                                     16: rgb565 (native endianness), 24: rgb24 (r, g, b) */
+  uint32_t          colours;                      /* number of colours (indices: grey = index * 255 / (colours - 1)) */
+  uint32_t          stride;                       /* bytes per row */
+  uint32_t          pid;                          /* producer */
+  volatile uint32_t active;                       /* 1 while frames are published, 0 after playback has ended */
+  volatile uint32_t seq;                          /* sequence number of the last frame published (0: none yet) */
+} export_header_t;
+
+typedef struct {
+  volatile uint32_t seq;                          /* sequence number of the frame in the slot (0: being written) */
+  uint32_t          reserved;
+  double            time;                         /* seconds since the first frame has been published (wall clock) */
+} export_slot_t;                                  /* followed by the frame (height * stride bytes) */
+
+typedef struct {
+  char*             name;                         /* name of the shared memory object */
+  export_header_t*  hdr;                          /* mapped shared memory object (NULL: not exported) */
+  size_t            size;
+  unsigned int      t0;                           /* GetTimer() of the first frame published */
+} sd_export_t;
+
+int  sd_exportopen(sd_export_t* ex, int width, int height, int depth, int colours, int stride, int slots);
+void sd_exportclose(sd_export_t* ex);
+void sd_exportframe(sd_export_t* ex, const unsigned char* buf);
+
+#endif /* MPLAYER_SERDISP_EXPORT_H */
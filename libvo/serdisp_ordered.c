@@ -0,0 +1,206 @@
+/*
+ * MPlayer
+ *
+ * ordered dithering for the video driver for serdisplib (vo_serdisp.c, option 'dither=2'):
+ * threshold matrices and quantisation kernels
+ *
+ */
+
+#include <string.h>
+#include <math.h>
+
+#include "serdisp_ordered.h"
+
+#ifdef SD_ORDERED_SSE2
+  #include <emmintrin.h>
+#endif
+#if HAVE_NEON
+  #include <arm_neon.h>
+#endif
+
+
+/* *********************************
+   sd_orderedbayer(rank, n) / sd_orderedbluenoise(rank, n)
+   *********************************
+   generates a threshold matrix for ordered dithering:
+   recursive bayer matrix or blue noise matrix (void-and-cluster method, toroidal gaussian energy)
+   *********************************
+   rank   ... output: n*n ranks [0, n*n-1]
+   n      ... dimension (bayer: power of 2)
+   *********************************
+   --
+*/
+void sd_orderedbayer(int* rank, int n) {
+  int x, y, m;
+
+  rank[0] = 0;
+  for (m = 1; m < n; m <<= 1) {
+    /* M(2m) = [ 4M  4M+2 ; 4M+3  4M+1 ] */
+    for (y = m - 1; y >= 0; y--) {
+      for (x = m - 1; x >= 0; x--) {
+        int v = rank[y * n + x] << 2;
+        rank[ y      * n + x    ] = v;
+        rank[ y      * n + x + m] = v + 2;
+        rank[(y + m) * n + x    ] = v + 3;
+        rank[(y + m) * n + x + m] = v + 1;
+      }
+    }
+  }
+}
+
+static int ordered_extremum(const double* energy, const unsigned char* pattern, int size, int value, int findmax) {
+  int i, best = -1;
+
+  for (i = 0; i < size; i++) {
+    if (pattern[i] == value && (best < 0 || (findmax ? (energy[i] > energy[best]) : (energy[i] < energy[best]))))
+      best = i;
+  }
+  return best;
+}
+
+static void ordered_energy(double* energy, const double* kernel, int n, int pos, double sign) {
+  int x, y, px = pos % n, py = pos / n;
+
+  for (y = 0; y < n; y++)
+    for (x = 0; x < n; x++)
+      energy[y * n + x] += sign * kernel[((y - py + n) % n) * n + ((x - px + n) % n)];
+}
+
+void sd_orderedbluenoise(int* rank, int n) {
+  int size = n * n;
+  int i, x, y, ones = 0, pos, pos2;
+  unsigned int seed = 1;
+  double kernel[SD_ORDERED_MAXSIZE * SD_ORDERED_MAXSIZE];
+  double energy[SD_ORDERED_MAXSIZE * SD_ORDERED_MAXSIZE];
+  unsigned char pattern[SD_ORDERED_MAXSIZE * SD_ORDERED_MAXSIZE];
+  unsigned char initial[SD_ORDERED_MAXSIZE * SD_ORDERED_MAXSIZE];
+
+  /* gaussian kernel (sigma = 1.5) using toroidal distances */
+  for (y = 0; y < n; y++) {
+    for (x = 0; x < n; x++) {
+      int dx = (x > n / 2) ? n - x : x;
+      int dy = (y > n / 2) ? n - y : y;
+      kernel[y * n + x] = exp(-(dx * dx + dy * dy) / (2.0 * 1.5 * 1.5));
+    }
+  }
+
+  /* initial binary pattern: ~10% minority pixels (deterministic pseudo random) */
+  memset(pattern, 0, size);
+  memset(energy, 0, sizeof(double) * size);
+  while (ones < size / 10) {
+    seed = seed * 1103515245 + 12345;
+    pos = (seed >> 16) % size;
+    if (!pattern[pos]) {
+      pattern[pos] = 1;
+      ordered_energy(energy, kernel, n, pos, 1.0);
+      ones++;
+    }
+  }
+
+  /* move points from tightest clusters to largest voids until stable */
+  for (i = 0; i < size; i++) {
+    pos = ordered_extremum(energy, pattern, size, 1, 1);
+    pattern[pos] = 0;
+    ordered_energy(energy, kernel, n, pos, -1.0);
+    pos2 = ordered_extremum(energy, pattern, size, 0, 0);
+    pattern[pos2] = 1;
+    ordered_energy(energy, kernel, n, pos2, 1.0);
+    if (pos == pos2)
+      break;
+  }
+  memcpy(initial, pattern, size);
+
+  /* phase 1: rank the points of the initial pattern by removing tightest clusters */
+  for (i = ones - 1; i >= 0; i--) {
+    pos = ordered_extremum(energy, pattern, size, 1, 1);
+    pattern[pos] = 0;
+    ordered_energy(energy, kernel, n, pos, -1.0);
+    rank[pos] = i;
+  }
+
+  /* phase 2: fill the largest voids */
+  memcpy(pattern, initial, size);
+  memset(energy, 0, sizeof(double) * size);
+  for (i = 0; i < size; i++)
+    if (pattern[i])
+      ordered_energy(energy, kernel, n, i, 1.0);
+  for (i = ones; i < size; i++) {
+    pos = ordered_extremum(energy, pattern, size, 0, 0);
+    pattern[pos] = 1;
+    ordered_energy(energy, kernel, n, pos, 1.0);
+    rank[pos] = i;
+  }
+}
+
+
+/* *********************************
+   sd_orderedquantise_*(idx, grey, thr, w, levels)
+   *********************************
+   quantises a row of grey values using thresholds: idx = (grey' * levels + thr) / 256
+   grey values are scaled to [0, 256] first (grey' = grey + grey / 128), so white (255) is quantised to levels
+   and black (0) to 0 for every threshold
+   (C version and SIMD versions, selected at runtime by vo_serdisp.c)
+   *********************************
+   idx    ... output: colour indices (may be identical to grey)
+   grey   ... grey values
+   thr    ... thresholds [0, 255]
+   w      ... number of pixels
+   levels ... number of colours - 1 (max. 255)
+   *********************************
+   --
+*/
+void sd_orderedquantise_c(unsigned char* idx, const unsigned char* grey, const unsigned char* thr, int w, int levels) {
+  int x;
+
+  for (x = 0; x < w; x++)
+    idx[x] = ((grey[x] + (grey[x] >> 7)) * levels + thr[x]) >> 8;
+}
+
+#ifdef SD_ORDERED_SSE2
+__attribute__((target("sse2")))
+void sd_orderedquantise_sse2(unsigned char* idx, const unsigned char* grey, const unsigned char* thr, int w, int levels) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i mul = _mm_set1_epi16(levels);
+  int x = 0;
+
+  /* 16 bit lanes: 256 * 255 + 255 doesn't overflow */
+  for (; x + 16 <= w; x += 16) {
+    __m128i g  = _mm_loadu_si128((const __m128i*)(grey + x));
+    __m128i t  = _mm_loadu_si128((const __m128i*)(thr + x));
+    __m128i gl = _mm_unpacklo_epi8(g, zero);
+    __m128i gh = _mm_unpackhi_epi8(g, zero);
+    __m128i lo, hi;
+
+    gl = _mm_add_epi16(gl, _mm_srli_epi16(gl, 7));
+    gh = _mm_add_epi16(gh, _mm_srli_epi16(gh, 7));
+    lo = _mm_add_epi16(_mm_mullo_epi16(gl, mul), _mm_unpacklo_epi8(t, zero));
+    hi = _mm_add_epi16(_mm_mullo_epi16(gh, mul), _mm_unpackhi_epi8(t, zero));
+
+    _mm_storeu_si128((__m128i*)(idx + x), _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+  }
+  sd_orderedquantise_c(idx + x, grey + x, thr + x, w - x, levels);
+}
+#endif
+
+#if HAVE_NEON
+void sd_orderedquantise_neon(unsigned char* idx, const unsigned char* grey, const unsigned char* thr, int w, int levels) {
+  const uint16x8_t mul = vdupq_n_u16(levels);
+  int x = 0;
+
+  for (; x + 16 <= w; x += 16) {
+    uint8x16_t g  = vld1q_u8(grey + x);
+    uint8x16_t t  = vld1q_u8(thr + x);
+    uint16x8_t gl = vmovl_u8(vget_low_u8(g));
+    uint16x8_t gh = vmovl_u8(vget_high_u8(g));
+    uint16x8_t lo, hi;
+
+    gl = vsraq_n_u16(gl, gl, 7);
+    gh = vsraq_n_u16(gh, gh, 7);
+    lo = vmlaq_u16(vmovl_u8(vget_low_u8(t)),  gl, mul);
+    hi = vmlaq_u16(vmovl_u8(vget_high_u8(t)), gh, mul);
+
+    vst1q_u8(idx + x, vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8)));
+  }
+  sd_orderedquantise_c(idx + x, grey + x, thr + x, w - x, levels);
+}
+#endif
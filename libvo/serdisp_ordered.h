@@ -0,0 +1,36 @@
+/*
+ * MPlayer
+ *
+ * ordered dithering for the video driver for serdisplib (vo_serdisp.c, option 'dither=2'):
+ * threshold matrices (bayer, blue noise) and quantisation kernels (C and SIMD versions)
+ *
+ */
+
+#ifndef MPLAYER_SERDISP_ORDERED_H
+#define MPLAYER_SERDISP_ORDERED_H
+
+#include "config.h"
+
+/* max. dimension of threshold matrices for ordered dithering */
+#define SD_ORDERED_MAXSIZE 32
+
+/* threshold [0, 255] of a rank of an n x n matrix, centred in its interval */
+#define SD_ORDERED_THR(_rank, _n)  ((((_rank) << 9) + 256) / ((_n) * (_n) * 2))
+
+/* SSE2 kernel: built for every x86 target (target attribute), used if the cpu supports SSE2 */
+#if HAVE_SSE2 && (defined(__i386__) || defined(__x86_64__))
+  #define SD_ORDERED_SSE2
+#endif
+
+void sd_orderedbayer(int* rank, int n);
+void sd_orderedbluenoise(int* rank, int n);
+
+void sd_orderedquantise_c(unsigned char* idx, const unsigned char* grey, const unsigned char* thr, int w, int levels);
+#ifdef SD_ORDERED_SSE2
+void sd_orderedquantise_sse2(unsigned char* idx, const unsigned char* grey, const unsigned char* thr, int w, int levels);
+#endif
+#if HAVE_NEON
+void sd_orderedquantise_neon(unsigned char* idx, const unsigned char* grey, const unsigned char* thr, int w, int levels);
+#endif
+
+#endif /* MPLAYER_SERDISP_ORDERED_H */
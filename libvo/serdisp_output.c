@@ -0,0 +1,419 @@
+/*
+ * MPlayer
+ *
+ * serdisplib output for the video driver for serdisplib (vo_serdisp.c):
+ * output context (single display or video wall of identical displays) and emulated display link
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "serdisp_output.h"
+#include "mp_msg.h"
+#include "osdep/timer.h"
+
+
+#ifndef SERDISP_STATIC
+long     (*fp_serdisp_getversioncode) (void);
+
+void*    (*fp_SDCONN_open)            (const char sdcddev[]);
+
+void*    (*fp_serdisp_init)           (void* sdcd, const char dispname[], const char extra[]);
+void     (*fp_serdisp_rewrite)        (void* dd);
+void     (*fp_serdisp_update)         (void* dd);
+void     (*fp_serdisp_clear)          (void* dd);
+int      (*fp_serdisp_isoption)       (void* dd, const char* optionname);
+void     (*fp_serdisp_setoption)      (void* dd, const char* optionname, long value);
+long     (*fp_serdisp_getoption)      (void* dd, const char* optionname, int* typesize);
+int      (*fp_serdisp_getwidth)       (void* dd);
+int      (*fp_serdisp_getheight)      (void* dd);
+int      (*fp_serdisp_getcolours)     (void* dd);
+int      (*fp_serdisp_getdepth)       (void* dd);
+int      (*fp_serdisp_getpixelaspect) (void* dd);
+void     (*fp_serdisp_quit)           (void* dd);
+
+void     (*fp_serdisp_setsdcol)       (void* dd, int x, int y, uint32_t colour);
+void     (*fp_serdisp_setsdgrey)      (void* dd, int x, int y, unsigned char grey);
+uint32_t (*fp_serdisp_getsdcol)       (void* dd, int x, int y);
+
+int      (*fp_serdisp_cliparea)       (void* dd, int x, int y, int w, int h, int sx, int sy, int cw, int ch, int inpmode, unsigned char* content);
+char*    (*fp_serdisp_defaultdevice)  (const char* dispname);
+
+char*    fp_sd_errormsg;
+#endif  /* SERDISP_STATIC */
+
+
+/* *********************************
+   link_emulate(out, start, bytes)
+   *********************************
+   emulated link (option 'linkspeed' of the vo): waits until transferring the bytes pushed would have been finished
+   *********************************
+   out    ... output context
+   start  ... GetTimer() at the beginning of the transfer
+   bytes  ... bytes pushed
+   *********************************
+   --
+*/
+static void link_emulate(sd_output_t* out, unsigned int start, unsigned long bytes) {
+  if (out->linkspeed > 0) {
+    int due = (int)((bytes * 8000000.0) / out->linkspeed);
+    int elapsed = (int)(GetTimer() - start);
+    if (due > elapsed)
+      usec_sleep(due - elapsed);
+  }
+}
+
+
+/* *********************************
+   sd_cliparea(out, x, y, w, h, sx, sy, cw, ch, inpmode, content)
+   *********************************
+   outputs an area of a buffer (see serdisp_cliparea()). video wall: the area is split at the panel borders
+   *********************************
+   out      ... output context
+   x/y/w/h  ... area on the display (wall)
+   sx/sy    ... start position of the area in the buffer
+   cw/ch    ... width/height of the buffer
+   inpmode  ... bits per pixel of the buffer
+   content  ... buffer
+   *********************************
+   --
+*/
+void sd_cliparea(sd_output_t* out, int x, int y, int w, int h, int sx, int sy, int cw, int ch, int inpmode,
+                 unsigned char* content) {
+  int p;
+
+  if (!out->dd)   /* frames are only exported (option 'shmgeometry') */
+    return;
+  if (!out->count) {
+    fp_serdisp_cliparea(out->dd, x, y, w, h, sx, sy, cw, ch, inpmode, content);
+    return;
+  }
+  for (p = 0; p < out->count; p++) {
+    sd_panel_t* pn = &out->panels[p];
+    int x0 = (x > pn->x) ? x : pn->x;
+    int y0 = (y > pn->y) ? y : pn->y;
+    int x1 = (x + w < pn->x + out->panel_width) ? x + w : pn->x + out->panel_width;
+    int y1 = (y + h < pn->y + out->panel_height) ? y + h : pn->y + out->panel_height;
+
+    if (x1 <= x0 || y1 <= y0)
+      continue;
+    fp_serdisp_cliparea(pn->dd, x0 - pn->x, y0 - pn->y, x1 - x0, y1 - y0, sx + x0 - x, sy + y0 - y, cw, ch, inpmode, content);
+    pn->bits += (x1 - x0) * (y1 - y0) * inpmode;
+  }
+}
+
+
+/* *********************************
+   sd_panel(out, x, y)
+   *********************************
+   video wall: gets the panel showing a pixel
+   *********************************
+   out    ... output context
+   x/y    ... position on the wall
+   *********************************
+   returns the panel, NULL if no panel is placed at this position
+   *********************************
+   --
+*/
+static inline sd_panel_t* sd_panel(sd_output_t* out, int x, int y) {
+  int p = out->grid[x / out->panel_width + (y / out->panel_height) * out->cols];
+
+  return (p < 0) ? NULL : &out->panels[p];
+}
+
+
+/* *********************************
+   sd_setsdgrey(out, x, y, grey) / sd_setsdcol(out, x, y, colour)
+   *********************************
+   sets a pixel (see serdisp_setsdgrey() / serdisp_setsdcol()), video wall: on the panel showing it
+   *********************************
+   --
+*/
+void sd_setsdgrey(sd_output_t* out, int x, int y, unsigned char grey) {
+  sd_panel_t* pn;
+
+  if (!out->dd)
+    return;
+  if (!out->count) {
+    fp_serdisp_setsdgrey(out->dd, x, y, grey);
+  } else if ((pn = sd_panel(out, x, y))) {
+    fp_serdisp_setsdgrey(pn->dd, x - pn->x, y - pn->y, grey);
+    pn->bits += out->depth;
+  }
+}
+
+void sd_setsdcol(sd_output_t* out, int x, int y, uint32_t colour) {
+  sd_panel_t* pn;
+
+  if (!out->dd)
+    return;
+  if (!out->count) {
+    fp_serdisp_setsdcol(out->dd, x, y, colour);
+  } else if ((pn = sd_panel(out, x, y))) {
+    fp_serdisp_setsdcol(pn->dd, x - pn->x, y - pn->y, colour);
+    pn->bits += out->depth;
+  }
+}
+
+
+/* *********************************
+   sd_clear(out)
+   *********************************
+   clears the display (all panels of a video wall)
+   *********************************
+   out    ... output context
+   *********************************
+   --
+*/
+void sd_clear(sd_output_t* out) {
+  int p;
+
+  if (!out->count && out->dd)
+    fp_serdisp_clear(out->dd);
+  for (p = 0; p < out->count; p++)
+    fp_serdisp_clear(out->panels[p].dd);
+}
+
+
+/* *********************************
+   panel_update(pn)
+   *********************************
+   video wall: updates a panel (including the emulated link) and resets the bits pushed to it
+   *********************************
+   pn     ... panel
+   *********************************
+   --
+*/
+static void panel_update(sd_panel_t* pn) {
+  unsigned int start = GetTimer();
+
+  fp_serdisp_update(pn->dd);
+  link_emulate(pn->out, start, (pn->bits + 7) >> 3);
+  pn->bits = 0;
+}
+
+
+#if HAVE_PTHREADS
+/* *********************************
+   wall_thread(arg)
+   *********************************
+   video wall: update thread of a panel, updates the panel whenever sd_update() is called
+   *********************************
+   arg    ... panel
+   *********************************
+   --
+*/
+static void* wall_thread(void* arg) {
+  sd_panel_t* pn = (sd_panel_t*)arg;
+  sd_output_t* out = pn->out;
+  unsigned int gen = 0;  /* out->gen is reset by wall_open() */
+
+  pthread_mutex_lock(&out->mutex);
+  for (;;) {
+    while (gen == out->gen && !out->quit)
+      pthread_cond_wait(&out->cond, &out->mutex);
+    if (out->quit)
+      break;
+    gen = out->gen;
+    pthread_mutex_unlock(&out->mutex);
+
+    panel_update(pn);
+
+    pthread_mutex_lock(&out->mutex);
+    if (--out->busy == 0)
+      pthread_cond_broadcast(&out->cond);
+  }
+  pthread_mutex_unlock(&out->mutex);
+  return NULL;
+}
+#endif
+
+
+/* *********************************
+   sd_update(out, bytes)
+   *********************************
+   updates the display (including the emulated link). video wall: all panels are updated in parallel,
+   returns once every panel has been updated
+   *********************************
+   out    ... output context
+   bytes  ... bytes pushed since the last update (single display, video wall: counted per panel)
+   *********************************
+   --
+*/
+void sd_update(sd_output_t* out, unsigned long bytes) {
+  unsigned int start = GetTimer();
+  int p = 1;
+
+  if (!out->dd)
+    return;
+  if (!out->count) {
+    fp_serdisp_update(out->dd);
+    link_emulate(out, start, bytes);
+    return;
+  }
+
+#if HAVE_PTHREADS
+  pthread_mutex_lock(&out->mutex);
+  out->busy = out->started;
+  out->gen++;
+  pthread_cond_broadcast(&out->cond);
+  pthread_mutex_unlock(&out->mutex);
+  p = out->started + 1;
+#endif
+
+  /* panel 0 and panels without a thread of their own */
+  panel_update(&out->panels[0]);
+  for (; p < out->count; p++)
+    panel_update(&out->panels[p]);
+
+#if HAVE_PTHREADS
+  pthread_mutex_lock(&out->mutex);
+  while (out->busy)
+    pthread_cond_wait(&out->cond, &out->mutex);
+  pthread_mutex_unlock(&out->mutex);
+#endif
+}
+
+
+/* *********************************
+   sd_wallclose(out) / sd_wallopen(out, wall, dispname, options)
+   *********************************
+   stops the update threads and closes the panels of the video wall /
+   opens the panels of a video wall. wall: panels separated by ';', every panel: <device>@<column>x<row>
+   *********************************
+   out      ... output context
+   wall     ... panels
+   dispname ... display name (identical for all panels)
+   options  ... serdisplib options (identical for all panels)
+   *********************************
+   sd_wallopen() returns 0 if successful, else -1
+   *********************************
+   --
+*/
+void sd_wallclose(sd_output_t* out) {
+  int p;
+
+#if HAVE_PTHREADS
+  if (out->started) {
+    pthread_mutex_lock(&out->mutex);
+    out->quit = 1;
+    pthread_cond_broadcast(&out->cond);
+    pthread_mutex_unlock(&out->mutex);
+    for (p = 0; p < out->started; p++)
+      pthread_join(out->threads[p], NULL);
+    out->started = 0;
+  }
+  pthread_mutex_destroy(&out->mutex);
+  pthread_cond_destroy(&out->cond);
+#endif
+  for (p = 0; p < out->count; p++)
+    fp_serdisp_quit(out->panels[p].dd);
+  out->count = 0;
+  out->dd = NULL;
+  if (out->grid) {
+    free(out->grid);
+    out->grid = NULL;
+  }
+}
+
+int sd_wallopen(sd_output_t* out, const char* wall, const char* dispname, const char* options) {
+  char* spec = strdup(wall);
+  char* entry;
+  char* next;
+  int p;
+
+  out->count = 0;
+  out->cols = out->rows = 0;
+#if HAVE_PTHREADS
+  out->started = 0;
+  pthread_mutex_init(&out->mutex, NULL);
+  pthread_cond_init(&out->cond, NULL);
+#endif
+  for (entry = spec; entry; entry = next) {
+    sd_panel_t* pn = &out->panels[out->count];
+    char* pos;
+
+    if ((next = strchr(entry, ';')))
+      *next++ = '\0';
+    if (!*entry)
+      continue;
+    pos = strrchr(entry, '@');
+    if (out->count >= SD_MAXPANELS || !pos || pos == entry || sscanf(pos + 1, "%dx%d", &pn->col, &pn->row) != 2 ||
+        pn->col < 0 || pn->row < 0 || pn->col >= SD_MAXPANELS || pn->row >= SD_MAXPANELS) {
+      mp_msg(MSGT_VO,MSGL_ERR,"vo_serdisp: invalid panel of video wall: %s (max. %d panels: <device>@<column>x<row>)\n",
+                              entry, SD_MAXPANELS);
+      free(spec);
+      sd_wallclose(out);
+      return -1;
+    }
+    *pos = '\0';
+
+    pn->out = out;
+    pn->bits = 0;
+    pn->sdcd = fp_SDCONN_open(entry);
+    if (!pn->sdcd) {
+      mp_msg(MSGT_VO,MSGL_ERR,"vo_serdisp: unable to open output device %s, additional info: %s\n", entry, fp_sd_errormsg);
+      free(spec);
+      sd_wallclose(out);
+      return -1;
+    }
+    pn->dd = fp_serdisp_init(pn->sdcd, dispname, (options) ? options : "");
+    if (!pn->dd) {
+      mp_msg(MSGT_VO,MSGL_ERR,"vo_serdisp: unknown display or unable to open %s, additional info: %s\n", dispname, fp_sd_errormsg);
+      free(spec);
+      sd_wallclose(out);
+      return -1;
+    }
+    out->count++;
+    if (pn->col >= out->cols)
+      out->cols = pn->col + 1;
+    if (pn->row >= out->rows)
+      out->rows = pn->row + 1;
+  }
+  free(spec);
+  if (!out->count) {
+    mp_msg(MSGT_VO,MSGL_ERR,"vo_serdisp: video wall without panels\n");
+    sd_wallclose(out);
+    return -1;
+  }
+
+  out->grid = (signed char*)malloc(out->cols * out->rows);
+  if (!out->grid) {
+    sd_wallclose(out);
+    return -1;
+  }
+  memset(out->grid, -1, out->cols * out->rows);
+  out->panel_width = fp_serdisp_getwidth(out->panels[0].dd);
+  out->panel_height = fp_serdisp_getheight(out->panels[0].dd);
+  for (p = 0; p < out->count; p++) {
+    sd_panel_t* pn = &out->panels[p];
+
+    if (out->grid[pn->col + pn->row * out->cols] >= 0 ||
+        fp_serdisp_getwidth(pn->dd) != out->panel_width || fp_serdisp_getheight(pn->dd) != out->panel_height ||
+        fp_serdisp_getdepth(pn->dd) != fp_serdisp_getdepth(out->panels[0].dd)) {
+      mp_msg(MSGT_VO,MSGL_ERR,"vo_serdisp: video wall: panels must be identical and placed at different positions\n");
+      sd_wallclose(out);
+      return -1;
+    }
+    out->grid[pn->col + pn->row * out->cols] = p;
+    pn->x = pn->col * out->panel_width;
+    pn->y = pn->row * out->panel_height;
+  }
+
+#if HAVE_PTHREADS
+  out->quit = 0;
+  out->gen = 0;
+  for (out->started = 0; out->started < out->count - 1; out->started++) {
+    if (pthread_create(&out->threads[out->started], NULL, wall_thread, &out->panels[out->started + 1])) {
+      mp_msg(MSGT_VO,MSGL_WARN,"vo_serdisp: unable to create update thread, %d panel(s) updated one after another\n",
+                               out->count - out->started);
+      break;
+    }
+  }
+#endif
+  out->dd = out->panels[0].dd;
+  return 0;
+}
@@ -0,0 +1,141 @@
+/*
+ * MPlayer
+ *
+ * serdisplib output for the video driver for serdisplib (vo_serdisp.c):
+ * binding of serdisplib (linked or loaded at runtime using dlopen() / dlsym()), output context
+ * (single display or video wall of identical displays) and emulated display link
+ *
+ */
+
+#ifndef MPLAYER_SERDISP_OUTPUT_H
+#define MPLAYER_SERDISP_OUTPUT_H
+
+#include <stdint.h>
+
+#include "config.h"
+
+#if HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+#if (CONFIG_SERDISP == 2)
+  #undef SERDISP_STATIC
+#else
+  #define SERDISP_STATIC
+#endif
+
+
+#ifdef SERDISP_STATIC
+  #include "serdisplib/serdisp.h"
+
+  #define fp_serdisp_getversioncode            serdisp_getversioncode
+  #define fp_SDCONN_open                       SDCONN_open
+  #define fp_serdisp_init                      serdisp_init
+  #define fp_serdisp_rewrite                   serdisp_rewrite
+  #define fp_serdisp_update                    serdisp_update
+  #define fp_serdisp_clear                     serdisp_clear
+  #define fp_serdisp_isoption                  serdisp_isoption
+  #define fp_serdisp_setoption                 serdisp_setoption
+  #define fp_serdisp_getoption                 serdisp_getoption
+  #define fp_serdisp_getwidth                  serdisp_getwidth
+  #define fp_serdisp_getheight                 serdisp_getheight
+  #define fp_serdisp_getcolours                serdisp_getcolours
+  #define fp_serdisp_getdepth                  serdisp_getdepth
+  #define fp_serdisp_getpixelaspect            serdisp_getpixelaspect
+  #define fp_serdisp_quit                      serdisp_quit
+
+  #define fp_serdisp_setsdcol                  serdisp_setsdcol
+  #define fp_serdisp_setsdgrey                 serdisp_setsdgrey
+  #define fp_serdisp_getsdcol                  serdisp_getsdcol
+
+  #define fp_serdisp_cliparea                  serdisp_cliparea
+  #define fp_serdisp_defaultdevice             serdisp_defaultdevice
+
+  #define fp_sd_errormsg                       sd_errormsg
+#else
+  /* default background/foreground colours */
+  #define SD_COL_BLACK      0xFF000000
+  #define SD_COL_WHITE      0xFFFFFFFF
+
+  /* calculation of serdisp version information */
+  #define SERDISP_VERSION(a,b) ((long)(((a) << 8) + (b)))
+  #define SERDISP_VERSION_GET_MAJOR(_c)  ((int)( (_c) >> 8 ))
+  #define SERDISP_VERSION_GET_MINOR(_c)  ((int)( (_c) & 0xFF ))
+
+  /* function pointers and error message, resolved by preinit() of vo_serdisp.c */
+  extern long     (*fp_serdisp_getversioncode) (void);
+
+  extern void*    (*fp_SDCONN_open)            (const char sdcddev[]);
+
+  extern void*    (*fp_serdisp_init)           (void* sdcd, const char dispname[], const char extra[]);
+  extern void     (*fp_serdisp_rewrite)        (void* dd);
+  extern void     (*fp_serdisp_update)         (void* dd);
+  extern void     (*fp_serdisp_clear)          (void* dd);
+  extern int      (*fp_serdisp_isoption)       (void* dd, const char* optionname);
+  extern void     (*fp_serdisp_setoption)      (void* dd, const char* optionname, long value);
+  extern long     (*fp_serdisp_getoption)      (void* dd, const char* optionname, int* typesize);
+  extern int      (*fp_serdisp_getwidth)       (void* dd);
+  extern int      (*fp_serdisp_getheight)      (void* dd);
+  extern int      (*fp_serdisp_getcolours)     (void* dd);
+  extern int      (*fp_serdisp_getdepth)       (void* dd);
+  extern int      (*fp_serdisp_getpixelaspect) (void* dd);
+  extern void     (*fp_serdisp_quit)           (void* dd);
+
+  extern void     (*fp_serdisp_setsdcol)       (void* dd, int x, int y, uint32_t colour);
+  extern void     (*fp_serdisp_setsdgrey)      (void* dd, int x, int y, unsigned char grey);
+  extern uint32_t (*fp_serdisp_getsdcol)       (void* dd, int x, int y);
+
+  extern int      (*fp_serdisp_cliparea)       (void* dd, int x, int y, int w, int h, int sx, int sy, int cw, int ch, int inpmode, unsigned char* content);
+  extern char*    (*fp_serdisp_defaultdevice)  (const char* dispname);
+
+  extern char*    fp_sd_errormsg;              /* extra error message */
+#endif  /* SERDISP_STATIC */
+
+
+/* video wall (option 'wall'): identical displays arranged in a grid form one display of (columns * panel width) x
+   (rows * panel height) pixels. frames are drawn in wall geometry and every panel is sent its part through its own
+   connection. the panels are updated in parallel (the calling thread updates panel 0, every other panel has its own
+   thread) and a frame is complete once all panels have been updated.
+   the state of the display (or the panels of a video wall) frames are output to is kept in an output context
+   that is passed to the sd_*() output functions */
+#define SD_MAXPANELS     16
+typedef struct sd_output_s sd_output_t;
+typedef struct {
+  sd_output_t*   out;                            /* output context the panel belongs to */
+  void*          sdcd;                           /* connect descriptor */
+  void*          dd;                             /* display descriptor */
+  int            col, row;                       /* position in the grid */
+  int            x, y;                           /* position in the wall (pixels) */
+  unsigned long  bits;                           /* bits pushed in the current frame */
+} sd_panel_t;
+struct sd_output_s {
+  void*            dd;                           /* single display (NULL: frames are only exported) */
+  int              depth;                        /* bits per pixel pushed to serdisplib */
+  int              linkspeed;                    /* emulated link speed in bits/s (0: no emulation) */
+  sd_panel_t       panels[SD_MAXPANELS];         /* video wall */
+  int              count;                        /* number of panels (0: single display) */
+  int              cols, rows;
+  signed char*     grid;                         /* panel at grid position col + row * cols (-1: none) */
+  int              panel_width, panel_height;
+#if HAVE_PTHREADS
+  pthread_t        threads[SD_MAXPANELS];
+  pthread_mutex_t  mutex;
+  pthread_cond_t   cond;
+  int              started;                      /* number of threads started (panels 1 .. started) */
+  int              quit;
+  unsigned int     gen;                          /* incremented for every display update */
+  int              busy;                         /* number of threads still updating their panel */
+#endif
+};
+
+void sd_cliparea(sd_output_t* out, int x, int y, int w, int h, int sx, int sy, int cw, int ch, int inpmode,
+                 unsigned char* content);
+void sd_setsdgrey(sd_output_t* out, int x, int y, unsigned char grey);
+void sd_setsdcol(sd_output_t* out, int x, int y, uint32_t colour);
+void sd_clear(sd_output_t* out);
+void sd_update(sd_output_t* out, unsigned long bytes);
+
+int  sd_wallopen(sd_output_t* out, const char* wall, const char* dispname, const char* options);
+void sd_wallclose(sd_output_t* out);
+
+#endif /* MPLAYER_SERDISP_OUTPUT_H */
@@ -0,0 +1,144 @@
+/*
+ * MPlayer
+ *
+ * progressive updates for the video driver for serdisplib (vo_serdisp.c, option 'progressive')
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "serdisp_prog.h"
+
+
+/* *********************************
+   sd_progfree(pr) / sd_proginit(pr, height)
+   *********************************
+   frees / allocates the row groups of progressive updates
+   *********************************
+   pr     ... progressive updates
+   height ... rows of the frames
+   *********************************
+   sd_proginit() returns 0 if successful, else -1
+   *********************************
+   --
+*/
+void sd_progfree(sd_prog_t* pr) {
+  if (pr->age) {
+    free(pr->age);
+    pr->age = NULL;
+  }
+  if (pr->bytes) {
+    free(pr->bytes);
+    pr->bytes = NULL;
+  }
+  if (pr->order) {
+    free(pr->order);
+    pr->order = NULL;
+  }
+  if (pr->send) {
+    free(pr->send);
+    pr->send = NULL;
+  }
+  pr->groups = 0;
+}
+
+int sd_proginit(sd_prog_t* pr, int height) {
+  pr->groups = (height + SD_PROG_ROWS - 1) / SD_PROG_ROWS;
+  pr->age = (unsigned int*)calloc(pr->groups, sizeof(unsigned int));
+  pr->bytes = (unsigned long*)malloc(pr->groups * sizeof(unsigned long));
+  pr->order = (prog_entry_t*)malloc(pr->groups * sizeof(prog_entry_t));
+  pr->send = (unsigned char*)malloc(pr->groups);
+  return (pr->age && pr->bytes && pr->order && pr->send) ? 0 : -1;
+}
+
+
+static int prog_cmp(const void* a, const void* b) {
+  const prog_entry_t* ea = (const prog_entry_t*)a;
+  const prog_entry_t* eb = (const prog_entry_t*)b;
+
+  return (ea->score < eb->score) ? 1 : ((ea->score > eb->score) ? -1 : (ea->group - eb->group));
+}
+
+
+/* *********************************
+   sd_progselect(pr, fr, budget)
+   *********************************
+   selects the row groups output for a frame (pr->send): groups containing rows that have to be output (invalidated,
+   eg. by the OSD) first, then the changed groups by priority (changed pixels * (frames waiting + 1)) until the budget
+   is used up. at least one changed group is selected per frame
+   *********************************
+   pr     ... progressive updates
+   fr     ... packed frame buffer and display content
+   budget ... bytes that may be output (0: unlimited)
+   *********************************
+   returns the number of changed groups carried over to the next frame
+   *********************************
+   --
+*/
+unsigned long sd_progselect(sd_prog_t* pr, const prog_frame_t* fr, unsigned long budget) {
+  unsigned long spent = 0, carried = 0;
+  int g, i, y, b, n = 0, sent = 0;
+
+  /* compare the groups with the display content, groups containing invalidated rows are always output */
+  for (g = 0; g < pr->groups; g++) {
+    int y0 = g * SD_PROG_ROWS, y1 = (y0 + SD_PROG_ROWS < fr->height) ? y0 + SD_PROG_ROWS : fr->height;
+    unsigned long changed = 0;
+    int rows = 0, forced = 0;
+    int b0 = fr->stride, b1 = -1;   /* first / last changed byte of the group */
+
+    for (y = y0; y < y1; y++) {
+      const unsigned char* row  = fr->buf  + y * fr->stride;
+      const unsigned char* prow = fr->prev + y * fr->stride;
+
+      if (fr->rowinvalid[y]) {
+        b0 = 0;
+        b1 = fr->stride - 1;
+      }
+      if (memcmp(row, prow, fr->stride)) {
+        for (b = 0; b < fr->stride; b++) {
+          unsigned char diff = row[b] ^ prow[b];
+
+          if (diff) {
+            changed += fr->diffpixels[diff];
+            if (b < b0) b0 = b;
+            if (b > b1) b1 = b;
+          }
+        }
+        rows++;
+      } else if (fr->rowinvalid[y]) {
+        rows++;
+      }
+      forced |= fr->rowinvalid[y];
+    }
+
+    pr->send[g] = forced;
+    if (forced) {
+      spent += rows * (b1 - b0 + 1);
+      pr->age[g] = 0;
+    } else if (changed) {
+      pr->bytes[g] = rows * (b1 - b0 + 1);
+      pr->order[n].score = changed * (pr->age[g] + 1);
+      pr->order[n].group = g;
+      n++;
+    } else {
+      pr->age[g] = 0;
+    }
+  }
+
+  /* changed groups by priority within the budget */
+  qsort(pr->order, n, sizeof(prog_entry_t), prog_cmp);
+  for (i = 0; i < n; i++) {
+    g = pr->order[i].group;
+    if (budget && sent && spent + pr->bytes[g] > budget) {
+      pr->age[g]++;
+      carried++;
+    } else {
+      spent += pr->bytes[g];
+      pr->send[g] = 1;
+      pr->age[g] = 0;
+      sent++;
+    }
+  }
+  return carried;
+}
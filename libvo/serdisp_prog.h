@@ -0,0 +1,44 @@
+/*
+ * MPlayer
+ *
+ * progressive updates for the video driver for serdisplib (vo_serdisp.c, option 'progressive'):
+ * selection of the row groups of a packed frame buffer that are output within a bytes per frame budget
+ *
+ */
+
+#ifndef MPLAYER_SERDISP_PROG_H
+#define MPLAYER_SERDISP_PROG_H
+
+/* the frame is compared with the display content in groups of rows, the groups changed most (weighted by the number
+   of frames they have been waiting) are output as long as the bytes per frame budget allows. groups not output stay
+   different and are carried over */
+#define SD_PROG_ROWS      8                /* rows per group */
+
+typedef struct {
+  unsigned long score;                     /* priority of the group in the current frame */
+  int           group;
+} prog_entry_t;
+
+typedef struct {
+  int            groups;
+  unsigned int*  age;                      /* frames a changed group has been waiting */
+  unsigned long* bytes;                    /* bytes needed to output the changed rows of a group */
+  prog_entry_t*  order;                    /* changed groups sorted by priority */
+  unsigned char* send;                     /* group is output in the current frame */
+} sd_prog_t;
+
+/* packed frame buffer compared by sd_progselect() */
+typedef struct {
+  const unsigned char* buf;                /* frame */
+  const unsigned char* prev;               /* display content */
+  const unsigned char* rowinvalid;         /* rows that need to be output even if unchanged */
+  const unsigned char* diffpixels;         /* number of changed pixels in (old byte ^ new byte) */
+  int                  stride;             /* bytes per row */
+  int                  height;
+} prog_frame_t;
+
+int  sd_proginit(sd_prog_t* pr, int height);
+void sd_progfree(sd_prog_t* pr);
+unsigned long sd_progselect(sd_prog_t* pr, const prog_frame_t* fr, unsigned long budget);
+
+#endif /* MPLAYER_SERDISP_PROG_H */
@@ -0,0 +1,105 @@
+/*
+ * MPlayer
+ *
+ * pre-rotation for the video driver for serdisplib (vo_serdisp.c, option 'prerotate')
+ *
+ */
+
+#include "serdisp_rotate.h"
+
+
+/* *********************************
+   sd_rotdegrees(value)
+   *********************************
+   converts the value of serdisplib option 'ROTATE' into degrees
+   (serdisplib returns its internal code: 1: 180, 2: 90, 3: 270 degrees)
+   *********************************
+   value  ... value returned by serdisp_getoption()
+   *********************************
+   returns 0, 90, 180 or 270
+   *********************************
+   --
+*/
+int sd_rotdegrees(long value) {
+  switch (value) {
+    case 1:   return 180;
+    case 2:   return 90;
+    case 3:   return 270;
+    case 90:
+    case 180:
+    case 270: return (int)value;
+  }
+  return 0;
+}
+
+
+/* *********************************
+   sd_rotate(dst, dststride, src, srcstride, srcw, srch, bpp, rot, sx, sy, w, h)
+   *********************************
+   rotates an area of a frame (video orientation) into display orientation.
+   the area is processed in tiles so that the rows read and written stay in cache
+   *********************************
+   dst       ... frame in display orientation
+   dststride ... bytes per row of dst
+   src       ... frame in video orientation (srcw x srch)
+   srcstride ... bytes per row of src
+   bpp       ... bytes per pixel (1, 2 or 3)
+   rot       ... rotation (clockwise): 90, 180 or 270 degrees
+   sx/sy     ... start position in dst
+   w/h       ... width/height of area
+   *********************************
+   --
+*/
+void sd_rotate(unsigned char* dst, int dststride, const unsigned char* src, int srcstride, int srcw, int srch, int bpp,
+               int rot, int sx, int sy, int w, int h) {
+  int tx, ty, x, y, x1, y1, dx, dy;
+  const unsigned char* base;
+
+  /* offset in src per phys. pixel (dx) and per phys. row (dy) */
+  switch (rot) {
+    case 90:    /* phys. (x, y) <- src (y, srch - 1 - x) */
+      base = src + (srch - 1) * srcstride;
+      dx = -srcstride;
+      dy = bpp;
+      break;
+    case 180:   /* phys. (x, y) <- src (srcw - 1 - x, srch - 1 - y) */
+      base = src + (srch - 1) * srcstride + (srcw - 1) * bpp;
+      dx = -bpp;
+      dy = -srcstride;
+      break;
+    default:    /* 270: phys. (x, y) <- src (srcw - 1 - y, x) */
+      base = src + (srcw - 1) * bpp;
+      dx = srcstride;
+      dy = -bpp;
+  }
+
+  for (ty = sy; ty < sy + h; ty += SD_ROT_TILE) {
+    y1 = (ty + SD_ROT_TILE < sy + h) ? ty + SD_ROT_TILE : sy + h;
+    for (tx = sx; tx < sx + w; tx += SD_ROT_TILE) {
+      x1 = (tx + SD_ROT_TILE < sx + w) ? tx + SD_ROT_TILE : sx + w;
+      for (y = ty; y < y1; y++) {
+        const unsigned char* p = base + y * dy + tx * dx;
+        unsigned char* d = dst + y * dststride + tx * bpp;
+
+        switch (bpp) {
+          case 1:
+            for (x = tx; x < x1; x++, p += dx)
+              *d++ = *p;
+            break;
+          case 2:
+            for (x = tx; x < x1; x++, p += dx, d += 2) {
+              d[0] = p[0];
+              d[1] = p[1];
+            }
+            break;
+          default:
+            for (x = tx; x < x1; x++, p += dx, d += 3) {
+              d[0] = p[0];
+              d[1] = p[1];
+              d[2] = p[2];
+            }
+        }
+      }
+    }
+  }
+}
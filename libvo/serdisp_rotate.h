@@ -0,0 +1,19 @@
+/*
+ * MPlayer
+ *
+ * pre-rotation for the video driver for serdisplib (vo_serdisp.c, option 'prerotate'):
+ * frames are rotated by the vo, serdisplib is used in native orientation
+ *
+ */
+
+#ifndef MPLAYER_SERDISP_ROTATE_H
+#define MPLAYER_SERDISP_ROTATE_H
+
+/* frames are rotated in tiles of SD_ROT_TILE x SD_ROT_TILE pixels */
+#define SD_ROT_TILE      32
+
+int  sd_rotdegrees(long value);
+void sd_rotate(unsigned char* dst, int dststride, const unsigned char* src, int srcstride, int srcw, int srch, int bpp,
+               int rot, int x, int y, int w, int h);
+
+#endif /* MPLAYER_SERDISP_ROTATE_H */
@@ -1,7 +1,7 @@
 /*
  * MPlayer
  * 
- * Video driver for serdisplib - 0.9.6
+ * Video driver for serdisplib - 0.9.7
  * 
  * by Wolfgang Astleitner <mrwastl@users.sourceforge.net>
  * 
@@ -19,22 +19,56 @@
  *                            removed support for very old serdisp version not supporting new colour functions to clean up code
  *                            get rid of compiler warning when calling sws_scale()
  *                2016-05-16: fix osd bug
+ * Version 0.9.7: 2026-10-16: greyscale/monochrome displays: draw into a packed frame buffer using native display depth
+ *                            and output it using serdisp_cliparea() (fallback: serdisp_setsdgrey() per pixel)
+ *                2026-10-16: dirty-region tracking: only output changed rows, skip serdisp_update() for unchanged frames
+ *                            (restricted to the changed columns of a run of rows)
+ *                2026-10-16: added option 'async': output frames using a display I/O thread
+ *                2026-10-16: added options 'framedrop' and 'maxfps': skip frames the display link can't keep up with
+ *                2026-10-16: tone curve lookup table (brightness/contrast, gamma, bandpass, threshold), equalizer support
+ *                2026-10-16: ordered dithering (dither=2, bayer / blue noise matrix, SSE2/NEON quantisation)
+ *                2026-10-16: added option 'threads': multi-threaded floyd steinberg dithering (wavefront), clip drawing area to display
+ *                2026-10-16: slice rendering: dithering errors are carried over between slices, accept strided input
+ *                2026-10-16: accept YV12/I420/NV12 input (greyscale/monochrome displays: luma plane only)
+ *                2026-10-16: direct rendering for yuv input that doesn't need to be scaled (greyscale/monochrome displays)
+ *                2026-10-16: fused downscaling (area average, tone curve, dithering in one pass) for large downscale ratios
+ *                2026-10-16: added option 'diffusion' (floyd steinberg, sierra lite, atkinson), kernels specialised per number of colours
+ *                2026-10-16: added option 'benchmark': benchmark drawing routine and OSD using synthetic frames
+ *                2026-10-16: added option 'linkspeed': emulate a slow display link (transfer time per byte pushed)
+ *                2026-10-16: per-stage timing (min/avg/p95/max) printed at uninit(), added options 'statsfile' and 'statsinterval'
+ *                2026-10-16: cached OSD overlay (progress bar and OSD text), rebuilt only if changed and composited row-wise
+ *                2026-10-16: truecolour displays: staging buffer in display geometry, serdisp_cliparea() is used for every aspect ratio,
+ *                            buffers for scaled frames are allocated in config() using the actual geometry
+ *                2026-10-16: 12/16 bit colour displays: frames are scaled to and output in rgb565, added option 'colourdither'
+ *                2026-10-16: pre-rotation: serdisplib option 'rot' is applied by the vo (tiled transpose before drawing),
+ *                            serdisplib is used in native orientation, added option 'prerotate'
+ *                2026-10-16: option 'threads': complete frames are scaled and drawn in horizontal bands (one sws context per band)
+ *                2026-10-16: added option 'cache': record frames as output (delta encoded), replay a valid cache instead of drawing
+ *                2026-10-17: added option 'hysteresis': temporally stable error diffusion, max. changed pixels per frame in statistics
+ *                2026-10-17: added options 'progressive' and 'framebytes': changed row groups are output by priority within a
+ *                            bytes per frame budget (measured link throughput), the rest is carried over to the next frames
+ *                2026-10-17: added option 'wall': video wall of identical displays (one connection and update thread per panel)
+ *                2026-10-17: added options 'shm', 'shmslots' and 'shmgeometry': frames are published into a shared memory ring
+ *                            buffer for external consumers (in addition to the display or without opening a display)
+ *                2026-10-17: output, frame export, playback cache, progressive updates and rotation moved into the modules
+ *                            serdisp_output.c, serdisp_export.c, serdisp_cache.c, serdisp_prog.c and serdisp_rotate.c
+ *                2026-10-17: ordered dithering: grey values are scaled to [0, 256] before quantisation (white is quantised to
+ *                            the last colour for every threshold), SSE2 kernel selected at runtime on every x86 build,
+ *                            matrices and kernels moved into serdisp_ordered.c (checked by tools/sdorderedcheck.c)
  *
  */
 
 #include "../config.h"
 
-#if (CONFIG_SERDISP == 2)
-  #undef SERDISP_STATIC
-#else
-  #define SERDISP_STATIC
-#endif
-
 #include <stdio.h>
 #include <stdlib.h>
 
 #include <sys/stat.h>
 #include <unistd.h>
+#include <fcntl.h>
+#if HAVE_SYS_MMAN_H
+  #include <sys/mman.h>
+#endif
 
 #include <limits.h>
 #include <math.h>
@@ -43,23 +77,35 @@
 #include <string.h>
 #include <errno.h>
 
+#if HAVE_PTHREADS
+  #include <pthread.h>
+#endif
+
 
 #include "video_out.h"
 #include "video_out_internal.h"
 #include "aspect.h"
 #include "libswscale/swscale.h"
+#include "libmpcodecs/vf.h"
 #include "libmpcodecs/vf_scale.h"
 #include "sub/sub.h"
 
 #include "osdep/keycodes.h"
+#include "osdep/timer.h"
 #include "m_option.h"
 #include "mp_msg.h"
 #include "subopt-helper.h"
+#include "cpudetect.h"
 
 
-#ifdef SERDISP_STATIC
-  #include "serdisplib/serdisp.h"
-#else
+#include "serdisp_output.h"
+#include "serdisp_export.h"
+#include "serdisp_cache.h"
+#include "serdisp_prog.h"
+#include "serdisp_rotate.h"
+#include "serdisp_ordered.h"
+
+#ifndef SERDISP_STATIC
   #include <dlfcn.h>   /* for dlopen() / dlsym() */
 #endif
 
@@ -84,41 +130,236 @@ const LIBVO_EXTERN(serdisp)
 /* range for greyvalues: [0 - 255] */
 #define MAX_GREYVALUE 255
 
-/* used for the sws */
+
+/* min. downscale ratio (both dimensions) for using the fused downscaling pipeline */
+#define SD_FUSED_RATIO   4
+
+/* max. number of drawing threads, pixels dithered by a thread before publishing its progress */
+#define SD_MAXTHREADS    16
+#define SD_FS_CHUNK      64
+
+/* per-stage timing: histogram buckets (8 per power of two, upper limit: 2^18 usec) */
+#define SD_STAGE_BUCKETS 128
+
+/* frame read by the drawing routines (display orientation, screen area) */
 static uint8_t * image[3] = {0,0,0};
 static int image_stride[3];
 
+/* used for the sws: frame in video orientation (image_width x image_height).
+   same as image[] unless the display is pre-rotated (the visible part is rotated into image[0] before drawing) */
+static uint8_t * image_scaled[3] = {0,0,0};
+static int image_scaledstride[3];
+static int image_bpp;                      /* bytes per pixel of scaled frames */
+static unsigned char* rot_scaled = NULL;   /* pre-rotation: scaled frame */
+static int rot_mode = 0;                   /* pre-rotation: 0, 90, 180, 270 degrees (clockwise) */
+
 /* image infos */
 static int image_format;
 static int image_width;
 static int image_height;
 static int image_colours;
+static int image_lumaonly = 0;             /* greyscale/monochrome: only the luma plane of yuv input is scaled (limited range) */
 static int screen_x, screen_y;
 static int screen_w, screen_h;
+static int slice_outy;                     /* next row of the scaled frame (slice rendering) */
 static int src_width;
 static int src_height;
 
 
+static int display_width, display_height;  /* phys. display dimensions */
+static int view_width, view_height;        /* display dimensions as seen by the viewer (swapped if rotated by 90/270 degrees) */
+static int display_depth;                  /* colour depth of display */
+
 static int istruecolour = 0;               /* monochrome/greyscale or truecolour image */
 static int isclipareasave = 1;             /* is it save to use serdisp_cliparea()? */
 
+/* truecolour displays: frame in display geometry (rgb, borders in background colour), output using full display rows.
+   sws scales directly into it (image[0] points to the screen area) if the screen area fits into the display,
+   else into tc_scaled and the visible part is copied */
+static unsigned char* tc_stage = NULL;
+static unsigned char* tc_scaled = NULL;
+static int tc_offset;                      /* offset of the screen area in tc_stage (sws scales directly into it) */
+static int tc_bpp = 3;                     /* bytes per pixel: 3 (rgb24) or 2 (rgb565, 12/16 bit colour displays) */
+static int tc_dither = 0;                  /* rgb565: frames are scaled to rgb24 and ordered dithered into tc_stage */
+static unsigned char tc_ditherthr[4][4];   /* bayer 4x4 ranks [0, 15] */
+static uint16_t* tone_lut565 = NULL;       /* tone curve applied to rgb565 pixels */
+static unsigned char* image_buf = NULL;    /* greyscale/monochrome: scaled luma plane */
+
+/* packed frame buffer in native display depth (monochrome/greyscale displays only).
+   pixels are stored as colour indices (0: black, image_colours-1: white), MSB first */
+static unsigned char* sdbuf = NULL;
+static int sdbuf_depth;                    /* bits per pixel: 1, 2, 4 (native depth) or 8 (depth not supported natively) */
+static int sdbuf_stride;                   /* bytes per row */
+static int sdbuf_xshift;                   /* x >> sdbuf_xshift: byte offset of pixel x in a row */
+static int sdbuf_xmask;                    /* pixels per byte - 1 */
+static int sdbuf_dshift;                   /* 1 << sdbuf_dshift == sdbuf_depth */
+static int sdbuf_idxmask;                  /* (1 << sdbuf_depth) - 1 */
+static int sdbuf_bgidx;                    /* colour index of background colour */
+static unsigned char* sdbuf_prev = NULL;  /* last frame that has been output (for dirty-region tracking) */
+static unsigned char* sdbuf_rowinvalid = NULL;  /* rows that need to be output even if unchanged */
+static unsigned char sdbuf_diffpixels[256];        /* number of changed pixels in (old byte ^ new byte) */
+static unsigned char grey2idx[MAX_GREYVALUE + 1];  /* grey value -> colour index */
+static unsigned char idx2grey[256];                /* colour index -> grey value */
+
+/* progressive updates (option 'progressive', greyscale/monochrome displays): the row groups changed most are output
+   within a bytes per frame budget, the rest is carried over (see serdisp_prog.h) */
+#define SD_PROG_LINKSHARE 80               /* percentage of the frame period the display link may be busy */
+static sd_prog_t      sd_prog;
+static int            prog_flushing = 0;   /* sdbuf_flush() called by prog_flush() (not deferred) */
+static unsigned long  stat_progcarried = 0;  /* changed groups carried over to the next frame */
+
+/* tone curve (brightness/contrast, gamma, bandpass), rebuilt by tone_build() whenever a parameter changes */
+static unsigned char tone_lut[MAX_GREYVALUE + 1];     /* grey value -> corrected grey value (dithering, truecolour) */
+static unsigned char tone_idxlut[MAX_GREYVALUE + 1];  /* grey value -> colour index (direct drawing incl. threshold) */
+static int tone_identity = 1;                         /* tone curve doesn't change anything */
+
+/* direct rendering (greyscale/monochrome displays, yuv input that doesn't need to be scaled):
+   the decoder draws into these buffers, the luma plane is dithered without any scaling or copying */
+#define SD_DR_BUFFERS    3
+static unsigned char* dr_buf[SD_DR_BUFFERS];          /* luma plane (stride: image_scaledstride[0]) followed by chroma planes */
+static int dr_possible = 0;                           /* direct rendering may be used with the current geometry */
+static int dr_height;                                 /* rows allocated for the luma plane */
+static int dr_ipbuf = 0;                              /* buffer of the last reference frame (0 or 1) */
+static unsigned long stat_drframes = 0;               /* frames drawn using direct rendering */
+
+/* fused downscaling (greyscale/monochrome displays, luma input, large downscale ratios): source rows are
+   area-averaged, tone mapped and dithered row by row, the frame is not scaled into image[0] by sws */
+static int  fused_enabled = 0;
+static int* fused_acc = NULL;                         /* column sums of the output row being accumulated */
+static int* fused_x0 = NULL;                          /* first source column of each output column (image_width + 1 entries) */
+static unsigned char* fused_line = NULL;              /* area averages of an output row */
+static int  fused_srcy;                               /* next source row expected */
+static int  fused_outy;                               /* output row being accumulated */
+
+/* error diffusion dithering: error buffers (row y writes fs_err[y % threads] and reads the one of row y-1,
+   atkinson: three buffers used round robin). every buffer has a guard element before and after the row */
+static int* fs_err[SD_MAXTHREADS];
+static int* fs_errinit = NULL;                        /* errors for the first row */
+static struct {
+  const unsigned char* src;                           /* first grey value of the area */
+  int sx, sy, w, h;
+  int cont;                                           /* area continues the one dithered before (next slice) */
+} fs_job;
+static int fs_nexty = -1;                             /* phys. row following the last row dithered (-1: new frame) */
+
+/* temporally stable error diffusion (option 'hysteresis'): a pixel keeps its colour index until its grey value
+   (after the tone curve) has moved more than the margin away from the value its index was chosen for */
+static short*         stab_ref = NULL;                /* grey value the index of a pixel was chosen for (display geometry) */
+static unsigned char* stab_idx = NULL;                /* colour index chosen */
+
+/* ordered dithering */
+static int ordered_size;                              /* dimension of threshold matrix */
+static unsigned char* ordered_thr = NULL;             /* thresholds [0, 255], one row per matrix row, tiled to display width */
+static unsigned char* ordered_line = NULL;            /* line buffer */
+static const char* ordered_kernelname = "C";
+static void (*ordered_quantise) (unsigned char* idx, const unsigned char* grey, const unsigned char* thr, int w, int levels);
+
 static  float serdisp_flag_gamma = 1.0;    /* gamma value */
 static  int serdisp_flag_gamma_enable = 0; /* gamma correction enabled (1) or disabled (0) */
 static  int serdisp_flag_bandpass = 0;     /* band pass filter for dithering (< value: black, > value: white) */
+static  int serdisp_eq_brightness = 0;     /* equalizer values, range: [-100, 100] */
+static  int serdisp_eq_contrast = 0;
 static  int serdisp_flag_threshold = 127;  /* threshold value for monochrome displays (higher than this value: set pixel, else: don't set) */
 static  int serdisp_flag_viewmode = 0;
-static  int serdisp_flag_algo = 1;         /* 0: threshold,  1: floyd steinberg */
+static  int serdisp_flag_algo = 1;         /* 0: threshold,  1: floyd steinberg,  2: ordered */
+static  int serdisp_flag_matrix = 1;       /* ordered dithering: 0: bayer 4x4,  1: bayer 8x8,  2: blue noise 32x32 */
+static  int serdisp_flag_diffusion = 0;    /* error diffusion kernel: 0: floyd steinberg,  1: sierra lite,  2: atkinson */
+static  int serdisp_flag_hysteresis = 0;   /* error diffusion: hysteresis margin for changing a pixel (0: off) */
 static  int serdisp_flag_debug = 0;        /* 0: no debug info, 1: show debug info */
+static  int serdisp_flag_async = 0;        /* 0: synchronous output, 1: output frames using a display I/O thread */
+static  int serdisp_flag_framedrop = 0;    /* 1: drop frames if the display link can't keep up */
+static  int serdisp_flag_maxfps = 0;       /* max. frames per second (0: no limit) */
+static  int serdisp_flag_threads = 1;      /* number of threads used for drawing (floyd steinberg, banded scaling/drawing) */
+static  int serdisp_flag_linkspeed = 0;    /* emulated link speed in bits/s (0: no emulation) */
+static  int serdisp_flag_benchmark = 0;    /* number of synthetic frames drawn for benchmarking in config() (0: no benchmark) */
+static  int serdisp_flag_statsinterval = 100;  /* write a line to the statistics file every n frames output */
+static  int serdisp_flag_colourdither = 0; /* rgb565 output: 0: truncate, 1: ordered dithering (bayer 4x4) */
+static  int serdisp_flag_prerotate = 1;    /* 1: rotation ('rot') is applied by the vo, 0: by serdisplib */
+static  int serdisp_flag_progressive = 0;  /* 1: progressive updates within a bytes per frame budget */
+static  int serdisp_flag_framebytes = 0;   /* progressive updates: bytes per frame (0: derived from link throughput) */
+static  int serdisp_flag_shmslots = 4;     /* frame export: number of slots in the ring buffer */
 
 
 static uint32_t  fg_colour;                   /* foreground colour */
 static uint32_t  bg_colour;                   /* background colour */
 
-static int  osd_updated = 0;                  /* needed for OSD cleanup hack */
+static int  sd_dirty = 0;                     /* display content changed since last serdisp_update() */
+
+/* statistics for dirty-region tracking */
+static unsigned long       frame_drawnpixels = 0;      /* pixels drawn / changed in current frame */
+static unsigned long       frame_changedpixels = 0;
+static unsigned long       stat_frames = 0;            /* accumulated values */
+static unsigned long       stat_skippedupdates = 0;
+static unsigned long       stat_asyncdropped = 0;     /* frames replaced in the mailbox before being output */
+static unsigned long       stat_framesskipped = 0;    /* frames dropped before scaling and drawing */
+static unsigned long long  stat_outputus = 0;         /* time between first and last frame output (usec) */
+static unsigned int        stat_lastoutput = 0;       /* GetTimer() of last frame output */
+
+/* adaptive frame skipping */
+static int     frame_skip = 0;                /* current frame is skipped (no scaling, drawing and output) */
+static int     frame_started = 0;             /* at least one frame has been drawn */
+static unsigned int frame_lasttime = 0;       /* GetTimer() of last frame drawn */
+static int     link_avgus = 0;                /* moving average of serdisp_update() duration (usec) */
+static double  link_rate = 0.0;               /* moving average of the link throughput (bytes/usec, 0: unknown) */
+static int     frame_periodus = 0;            /* moving average of the time between two frames drawn (usec, 0: unknown) */
+static unsigned long long  stat_drawnpixels = 0;
+static unsigned long long  stat_changedpixels = 0;
+static unsigned long       stat_maxchangedpixels = 0;  /* max. pixels changed in one frame */
+static unsigned long       frame_bytes = 0;            /* bytes pushed to serdisplib in current frame (display depth) */
+static unsigned long long  stat_bytes = 0;
+
+/* per-stage timing. every stage is accumulated per frame and recorded once the frame is complete:
+   sws, drawing: in flip_page(),  osd, osd cleanup, update: in output_update() (display I/O thread if 'async') */
+enum { STAGE_SWS = 0, STAGE_DRAWING, STAGE_OSD, STAGE_OSDCLEANUP, STAGE_UPDATE, SD_STAGES };
+
+typedef struct {
+  const char*         name;
+  unsigned long       n;                          /* number of frames the stage was part of */
+  unsigned int        min, max;                   /* usec */
+  unsigned long long  sum;
+  unsigned int        hist[SD_STAGE_BUCKETS];     /* histogram for percentiles */
+} stage_stat_t;
+
+static stage_stat_t  stage_stats[SD_STAGES] = {
+  { .name = "sws" }, { .name = "drawing" }, { .name = "osd" }, { .name = "osd_cleanup" }, { .name = "update" }
+};
+static unsigned int  stage_frameus[SD_STAGES];    /* duration of the stages in current frame (usec) */
+static int           stage_framehit[SD_STAGES];   /* stage was part of current frame */
+static FILE*         stats_file = NULL;           /* option 'statsfile' */
+
+/* playback cache (option 'cache'): frames as output (packed frame buffer / staging buffer, without OSD) are recorded
+   as runs of rows changed since the last frame. a cache matching display and flags is replayed by flip_page():
+   the frames passed by the player are not drawn, the recorded ones are output instead (see serdisp_cache.h) */
+static sd_cache_t     sd_cache;
+static char*          cache_id = NULL;            /* display part of the key (name, device, serdisplib options) */
+static int            cache_configured = 0;       /* config() has been called */
+static uint32_t       cache_flips = 0;            /* flip_page() calls since preinit() */
+
+static sd_export_t      sd_exp;                  /* frame export (option 'shm'), see serdisp_export.h */
+
 static int  osd_height = -1;                  /* pre-calculated position and size values for osd */
 static int  osd_margin = SD_OSD_MARGIN;
 static int  osd_bar_height = -1;
 static int  osd_posy = -1;
+static int  osd_progbar_type = -1;            /* progress bar state of the cached overlay */
+static int  osd_progbar_value = 0;
+
+/* cached OSD overlay: progress bar and OSD text are rendered into a greyscale layer (display geometry) only if
+   they have changed (osd_build()). the layer is converted into display format and composited with the frame
+   output (osd_blit()). asynchronous output: the layer is built by the main thread, converted and blitted
+   by the display I/O thread (both protected by async_mutex) */
+static unsigned char* osd_layer = NULL;           /* grey values (view_width x view_height) */
+static unsigned char* osd_layeralpha = NULL;      /* 1: pixel covered by the OSD */
+static int  osd_layery0 = 0, osd_layery1 = 0;     /* rows covered by the layer */
+static unsigned char* osd_rotrow = NULL;          /* pre-rotation: row of the layer in display orientation (grey values, alpha) */
+static unsigned int osd_layergen = 0;             /* incremented whenever the layer is rebuilt */
+static unsigned char* osd_ovl = NULL;             /* overlay in display format (greyscale: packed colour indices, truecolour: rgb) */
+static unsigned char* osd_ovlmask = NULL;         /* pixels covered (greyscale: packed index masks, truecolour: one byte per pixel) */
+static unsigned char* osd_comp = NULL;            /* rows composited from frame and overlay */
+static int  osd_ovlstride, osd_maskstride;        /* bytes per row */
+static int  osd_ovly0 = 0, osd_ovly1 = 0;         /* rows covered by the overlay */
+static unsigned int osd_ovlgen = 0;               /* layer generation the overlay was converted from */
+static int  osd_blity0 = 0, osd_blity1 = 0;       /* rows blitted over the last frame (restored by osd_cleanup()) */
 
 static struct SwsContext *sws=NULL;
 
@@ -135,7 +376,7 @@ static const char help_msg[] =
     "\n-vo serdisp command line help:\n"
     "Example: mplayer -vo serdisp:name=sdl:device=out?:viewmode=1:options=brightness=30\n"
     "\nOptions:\n"
-    "    name (required)\n"
+    "    name (required, unless shmgeometry is given)\n"
     "      driver-name in serdisplib (e.g.: 'rs232')\n"
     "    device (optional, if not given, default device for <name> is used (serdisplib >= 2.01))\n"
     "      device string (e.g.: 'RS232?/dev/usb/ttyUSB0')\n"
@@ -152,17 +393,75 @@ static const char help_msg[] =
     "    debug (default: 0)\n"
     "      0: no debug information\n"
     "      1: print debug information\n"
+    "    async (default: 0)\n"
+    "      0: output frames synchronously\n"
+    "      1: output frames using a separate display I/O thread (frames are dropped if the display is too slow)\n"
+    "    framedrop (default: 0)\n"
+    "      0: draw all frames\n"
+    "      1: skip frames before scaling/drawing if the display link can't keep up\n"
+    "    maxfps (default: 0)\n"
+    "      max. frames per second drawn (0: no limit)\n"
+    "    linkspeed (default: 0)\n"
+    "      emulate a slow display link: bits/s (0: no emulation)\n"
+    "    progressive (monochrome/greyscale displays, default: 0)\n"
+    "      1: output the row groups changed most within a bytes per frame budget, carry the rest over to the next frames\n"
+    "    framebytes (default: 0)\n"
+    "      budget for progressive updates in bytes per frame (0: derived from the measured link throughput)\n"
+    "    benchmark (default: 0)\n"
+    "      number of synthetic frames drawn to benchmark the drawing routine and the OSD before playback (not with 'async')\n"
+    "    statsfile (optional)\n"
+    "      write per-stage timing statistics (csv) to this file (accumulated values, one line every 'statsinterval' frames)\n"
+    "    statsinterval (default: 100)\n"
+    "      number of frames output between two lines written to 'statsfile'\n"
+    "    prerotate (default: 1)\n"
+    "      0: rotation (serdisplib option 'rot') is applied by serdisplib\n"
+    "      1: frames are rotated by the vo, serdisplib is used in native orientation (faster)\n"
+    "    threads (default: 1)\n"
+    "      number of drawing threads (max. 16). error diffusion dithering: rows are dithered as a wavefront\n"
+    "      (result is identical to using one thread), else complete frames are scaled and drawn in horizontal bands\n"
+    "    cache (optional)\n"
+    "      playback cache file: frames are recorded into it. if it matches display, options, flags and equalizer,\n"
+    "      the frames recorded are output instead of drawing the video\n"
+    "    wall (optional)\n"
+    "      video wall of identical displays ('name', 'options'): list of <device>@<column>x<row>, separated by ';'\n"
+    "      (':' in devices replaced by '?'). every panel has its own connection and is updated by its own thread\n"
+    "      e.g.: wall=RS232?/dev/ttyUSB0@0x0;RS232?/dev/ttyUSB1@1x0 ('device' is ignored)\n"
+    "    shm (optional)\n"
+    "      name of a POSIX shared memory object (e.g. /serdisp): frames as output (without OSD) are published into a\n"
+    "      ring buffer for external consumers (layout: see README.md)\n"
+    "    shmslots (default: 4)\n"
+    "      number of frames in the ring buffer (2 - 64)\n"
+    "    shmgeometry (optional)\n"
+    "      <width>x<height>x<depth>: no display is opened, frames are only published ('shm' required, 'name' not needed)\n"
+    "      depth: 1, 2, 4 (greyscale), 16 or 24 (colour)\n"
+    "\n\n"
+    "  Options only applicable when using 12 or 16 bit colour displays:\n"
+    "    colourdither (default: 0)\n"
+    "      0 : truncate to rgb565\n"
+    "      1 : ordered dithering to rgb565 (bayer 4x4, avoids banding in gradients)\n"
     "\n\n"
     "  Options only applicable when using monochrome or greyscale displays:\n"
     "    dither (default: 1) \n"
     "      0 : threshold\n"
-    "      1 : floyd steinberg\n"
+    "      1 : error diffusion (floyd steinberg, see option 'diffusion')\n"
+    "      2 : ordered (threshold matrix, see option 'matrix')\n"
+    "    matrix (only valid for ordered dithering, default: 1)\n"
+    "      0 : bayer 4x4\n"
+    "      1 : bayer 8x8\n"
+    "      2 : blue noise 32x32\n"
+    "    diffusion (only valid for error diffusion dithering, default: 0)\n"
+    "      0 : floyd steinberg\n"
+    "      1 : sierra lite\n"
+    "      2 : atkinson (always uses one thread)\n"
+    "    hysteresis (only valid for error diffusion dithering, default: 0)\n"
+    "      temporally stable dithering: a pixel keeps its colour until its grey value has changed by more than\n"
+    "      this value, value in [0, 255] (0: off, every frame is dithered from scratch)\n"
     "    threshold (only valid for monochrome displays, default: 127)\n"
     "      threshold value for threshold dithering, value in [0, 255]\n"
     "    bandpass (default: 30)\n"
     "      bandpass value for floyd steinberg dithering, value in [0, 255]\n"
     "    gamma (default: 1.0)\n"
-    "      gamma correction\n"
+    "      gamma correction (may be changed at runtime using the equalizer, as well as brightness and contrast)\n"
     "\n"
     ;
 
@@ -171,71 +470,13 @@ static const char help_msg[] =
 #ifdef SERDISP_STATIC
   static serdisp_t*      dd;
   static serdisp_CONN_t* sdcd;
-
-/*  extern char*           sd_errormsg;   */              /* extra error message */
-  #define fp_serdisp_getversioncode            serdisp_getversioncode
-  #define fp_SDCONN_open                       SDCONN_open
-  #define fp_serdisp_init                      serdisp_init
-  #define fp_serdisp_rewrite                   serdisp_rewrite
-  #define fp_serdisp_update                    serdisp_update
-  #define fp_serdisp_clear                     serdisp_clear
-  #define fp_serdisp_isoption                  serdisp_isoption
-  #define fp_serdisp_setoption                 serdisp_setoption
-  #define fp_serdisp_getoption                 serdisp_getoption
-  #define fp_serdisp_getwidth                  serdisp_getwidth
-  #define fp_serdisp_getheight                 serdisp_getheight
-  #define fp_serdisp_getcolours                serdisp_getcolours
-  #define fp_serdisp_getdepth                  serdisp_getdepth
-  #define fp_serdisp_getpixelaspect            serdisp_getpixelaspect
-  #define fp_serdisp_quit                      serdisp_quit
-
-  #define fp_serdisp_setsdcol                  serdisp_setsdcol
-  #define fp_serdisp_setsdgrey                 serdisp_setsdgrey
-  #define fp_serdisp_getsdcol                  serdisp_getsdcol
-
-  #define fp_serdisp_cliparea                  serdisp_cliparea
-  #define fp_serdisp_defaultdevice             serdisp_defaultdevice
 #else
   char* errmsg; /* error message returned by dlerror() */
-  /* default background/foreground colours */
-  #define SD_COL_BLACK      0xFF000000
-  #define SD_COL_WHITE      0xFFFFFFFF
-
-  /* calculation of serdisp version information */
-  #define SERDISP_VERSION(a,b) ((long)(((a) << 8) + (b)))
-  #define SERDISP_VERSION_GET_MAJOR(_c)  ((int)( (_c) >> 8 ))
-  #define SERDISP_VERSION_GET_MINOR(_c)  ((int)( (_c) & 0xFF ))
 
-  /* dyn.loaded stuff: dyn.loaded libraries, function pointers, ... */
+  /* dyn.loaded stuff: dyn.loaded libraries, display descriptors (function pointers: serdisp_output.h) */
   static void*    sdhnd;                       /* serdisplib handle */
   static void*    dd;                          /* display descriptor */
   static void*    sdcd;                        /* serdisp connect descriptor */
-  static char*    sd_errormsg;                 /* extra error message */
-
-  static long     (*fp_serdisp_getversioncode) (void);
-
-  static void*    (*fp_SDCONN_open)            (const char sdcddev[]);
-
-  static void*    (*fp_serdisp_init)           (void* sdcd, const char dispname[], const char extra[]);
-  static void     (*fp_serdisp_rewrite)        (void* dd);
-  static void     (*fp_serdisp_update)         (void* dd);
-  static void     (*fp_serdisp_clear)          (void* dd);
-  static int      (*fp_serdisp_isoption)       (void* dd, const char* optionname);
-  static void     (*fp_serdisp_setoption)      (void* dd, const char* optionname, long value);
-  static long     (*fp_serdisp_getoption)      (void* dd, const char* optionname, int* typesize);
-  static int      (*fp_serdisp_getwidth)       (void* dd);
-  static int      (*fp_serdisp_getheight)      (void* dd);
-  static int      (*fp_serdisp_getcolours)     (void* dd);
-  static int      (*fp_serdisp_getdepth)       (void* dd);
-  static int      (*fp_serdisp_getpixelaspect) (void* dd);
-  static void     (*fp_serdisp_quit)           (void* dd);
-
-  static void     (*fp_serdisp_setsdcol)       (void* dd, int x, int y, uint32_t colour);
-  static void     (*fp_serdisp_setsdgrey)      (void* dd, int x, int y, unsigned char grey);
-  static uint32_t (*fp_serdisp_getsdcol)       (void* dd, int x, int y);
-
-  static int      (*fp_serdisp_cliparea)       (void* dd, int x, int y, int w, int h, int sx, int sy, int cw, int ch, int inpmode, unsigned char* content);
-  static char*    (*fp_serdisp_defaultdevice)  (const char* dispname);
 
   /* some macros to simplify life */
   #define dlerror_die(_symbol) { if ( (errmsg = dlerror()) != 0  ) { \
@@ -248,6 +489,53 @@ static const char help_msg[] =
 static void     (*drawing_algo)              (unsigned char** image, int sx, int sy, int w, int h);
 
 
+#if HAVE_PTHREADS
+/* asynchronous output: a display I/O thread outputs a frame while the next one is drawn.
+   frames are handed over using a one-slot mailbox (a frame still waiting in the mailbox
+   when the next one is handed over is dropped), so drawing never waits for the display.
+   buffer ownership: the back buffer (sdbuf or tc_stage) is drawn by the main thread and swapped with
+   async_pendingbuf by async_handover() (holding async_mutex). async_frontbuf, sdbuf_prev and sdbuf_rowinvalid
+   belong to the display I/O thread while async_busy is set (sdbuf_flush(), prog_flush() and osd_cleanup() run there);
+   the main thread touches them only after async_wait() */
+static pthread_t        async_thread;
+static pthread_mutex_t  async_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   async_cond  = PTHREAD_COND_INITIALIZER;
+static int              async_started = 0;       /* display I/O thread is running */
+static int              async_quit = 0;          /* display I/O thread is requested to terminate */
+static int              async_pending = 0;       /* a frame is waiting in the mailbox */
+static int              async_busy = 0;          /* display I/O thread is outputting a frame */
+static unsigned char*   async_pendingbuf = NULL; /* mailbox */
+static unsigned char*   async_frontbuf = NULL;   /* frame that is output by the display I/O thread */
+
+/* drawing threads (option 'threads'): the calling thread is thread 0, threads 1 .. pool_size-1 are started
+   in preinit() and run the job passed to pool_run() */
+static pthread_t        pool_threads[SD_MAXTHREADS];
+static pthread_mutex_t  pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   pool_cond  = PTHREAD_COND_INITIALIZER;
+static int              pool_started = 0;        /* number of threads started */
+static int              pool_quit = 0;
+static unsigned int     pool_jobid = 0;          /* incremented for every job */
+static int              pool_busy = 0;           /* number of threads still working on the current job */
+static void           (*pool_job) (int t, int n);
+static int              fs_progress[SD_MAXTHREADS];  /* progress of the row dithered by thread t: row * (w+1) + pixels done */
+#endif
+static int              pool_size = 1;           /* number of threads used for drawing (incl. calling thread) */
+
+/* banded scaling and drawing of complete frames (option 'threads'): band b covers rows band_y[b] .. band_y[b+1]-1
+   of the scaled frame and is scaled from source rows band_srcy[b] .. band_srcy[b+1]-1 using its own sws context */
+static struct SwsContext* band_sws[SD_MAXTHREADS];
+static int              band_count = 0;          /* 0: frames are scaled using one sws context */
+static int              band_srcy[SD_MAXTHREADS + 1];
+static int              band_y[SD_MAXTHREADS + 1];
+static struct {
+  uint8_t* src[3];                               /* source frame */
+  int      stride[3];
+  int      sx, sy, w, h;                         /* area drawn (phys.) */
+} band_job;
+
+static sd_output_t      sd_out;                  /* display (or video wall) frames are output to, see serdisp_output.h */
+
+
 static char* my_replace(char *str, const char fromchar, const char tochar) {
   int i;
   if (!str)
@@ -260,76 +548,729 @@ static char* my_replace(char *str, const char fromchar, const char tochar) {
 
 
 /* *********************************
-   drawingalgo_dithergrey(image, sx, sy, w, h)
+   sdbuf_setidx(x, y, idx) / sdbuf_getidx(buf, x, y)
    *********************************
-   dithers a frame on a monochrome/greyscale display using floyd-steinberg dithering
+   sets a colour index in the packed frame buffer that is currently drawn into /
+   gets a colour index from a packed frame buffer
    *********************************
-   image  ... mplayer frame
+   buf    ... packed frame buffer
+   x/y    ... phys. position
+   idx    ... colour index
+   *********************************
+   --
+*/
+static inline void sdbuf_setidx(int x, int y, int idx) {
+  unsigned char* p = sdbuf + y * sdbuf_stride + (x >> sdbuf_xshift);
+  int shift = ((~x) & sdbuf_xmask) << sdbuf_dshift;
+
+  *p = (*p & ~(sdbuf_idxmask << shift)) | (idx << shift);
+}
+
+static inline int sdbuf_getidx(const unsigned char* buf, int x, int y) {
+  int shift = ((~x) & sdbuf_xmask) << sdbuf_dshift;
+
+  return (buf[y * sdbuf_stride + (x >> sdbuf_xshift)] >> shift) & sdbuf_idxmask;
+}
+
+
+/* *********************************
+   sdbuf_clear(buf)
+   *********************************
+   fills a packed frame buffer with the background colour
+   *********************************
+   buf    ... packed frame buffer
+   *********************************
+   --
+*/
+static void sdbuf_clear(unsigned char* buf) {
+  int b, bgbyte = 0;
+
+  for (b = 0; b < 8; b += sdbuf_depth)
+    bgbyte |= sdbuf_bgidx << b;
+  memset(buf, bgbyte, sdbuf_stride * display_height);
+}
+
+
+/* *********************************
+   sdbuf_invalidate(sy, h)
+   *********************************
+   forces rows to be output on the next call of sdbuf_flush() even if unchanged
+   (eg. because they were overdrawn by the OSD)
+   *********************************
+   sy/h   ... first row / number of rows
+   *********************************
+   --
+*/
+static void sdbuf_invalidate(int sy, int h) {
+  int y;
+
+  if (!sdbuf_rowinvalid)
+    return;
+
+  for (y = (sy < 0) ? 0 : sy; y < sy + h && y < display_height; y++)
+    sdbuf_rowinvalid[y] = 1;
+}
+
+
+/* *********************************
+   sdbuf_output(buf, sx, sy, w, h)
+   *********************************
+   outputs an area of a packed frame buffer to serdisplib.
+   if serdisp_cliparea() may be used, all rows of the area are transferred using one call
+   (the columns are widened to whole bytes of the packed frame buffer), else the area is drawn pixel by pixel
+   *********************************
+   buf    ... packed frame buffer
    sx/sy  ... phys. start position
-   w/h    ... width/height of frame
+   w/h    ... width/height of area
    *********************************
    --
 */
-static void drawingalgo_dithergrey(unsigned char** image, int sx, int sy, int w, int h) {
+static void sdbuf_output(unsigned char* buf, int sx, int sy, int w, int h) {
   int x, y;
-  int xslop, dslop;
-  int yslop[w];
-  int i, j, k, t, q;
 
-  double f = 0.0;
-
-  unsigned char* buffer = image[0];
+  if (isclipareasave) {
+    int b0 = sx >> sdbuf_xshift;                  /* first / last byte of the area */
+    int b1 = (sx + w - 1) >> sdbuf_xshift;
+    int x0 = b0 << sdbuf_xshift;
+    int x1 = (b1 + 1) << sdbuf_xshift;
+
+    if (x1 > display_width) x1 = display_width;
+    /* inpmode < 8: content is packed using <inpmode> bits per pixel */
+    sd_cliparea(&sd_out, x0, sy, x1 - x0, h, x0, sy, display_width, display_height, sdbuf_depth, buf);
+    frame_bytes += (b1 - b0 + 1) * h;
+  } else {
+    for (y = sy; y < sy + h; y++) {
+      for (x = sx; x < sx + w; x++) {
+        sd_setsdgrey(&sd_out, x, y, idx2grey[sdbuf_getidx(buf, x, y)]);
+      }
+    }
+    frame_bytes += (w * h * display_depth + 7) >> 3;
+  }
+  sd_dirty = 1;
+}
 
-  t = ((MAX_GREYVALUE + 1) * 2) / image_colours;  /* threshold factor */
-  q = MAX_GREYVALUE / (image_colours-1);          /* quantisation factor */
-  j = (9 * MAX_GREYVALUE) / 32;
-  for (x = 0; x < w; x++)
-    yslop[x] = j;
 
-  for (y = 0; y < h; y++) {
-    xslop = (7 * MAX_GREYVALUE) / 32;
-    dslop = MAX_GREYVALUE / 32;
+/* *********************************
+   sdbuf_flush(buf, sx, sy, w, h)
+   *********************************
+   compares an area of a packed frame buffer with the last frame that has been output
+   and outputs runs of changed rows only, restricted to the columns changed within the run.
+   progressive updates: output is deferred to prog_flush() at the end of the frame
+   *********************************
+   buf    ... packed frame buffer
+   sx/sy  ... phys. start position
+   w/h    ... width/height of area
+   *********************************
+   --
+*/
+static void sdbuf_flush(unsigned char* buf, int sx, int sy, int w, int h) {
+  int y, b;
+  int run_y = -1;                 /* first row of current run of changed rows */
+  int run_b0 = 0, run_b1 = 0;     /* first / last changed byte in current run */
+  unsigned char diff;
+
+  if (h <= 0 || w <= 0)
+    return;
+
+  if (!prog_flushing) {
+    frame_drawnpixels += w * h;
+    if (serdisp_flag_progressive)
+      return;
+  }
 
-    for (x = 0; x < w; x++) {
-      i = buffer[x+(sx-screen_x) + (y+(sy-screen_y)) * image_width];
+  for (y = sy; y <= sy + h; y++) {
+    int b0 = -1, b1 = -1;
 
-      if (serdisp_flag_gamma_enable) {
-        f = pow((double)i / 255.0, 1.0 / serdisp_flag_gamma);
+    if (y < sy + h) {
+      unsigned char* row  = buf        + y * sdbuf_stride;
+      unsigned char* prow = sdbuf_prev + y * sdbuf_stride;
 
-        i = (int)(f * 255.0);
+      if (memcmp(row, prow, sdbuf_stride)) {
+        for (b = 0; b < sdbuf_stride; b++) {
+          if ((diff = row[b] ^ prow[b])) {
+            frame_changedpixels += sdbuf_diffpixels[diff];
+            if (b0 < 0) b0 = b;
+            b1 = b;
+          }
+        }
+        memcpy(prow, row, sdbuf_stride);
+      }
+      if (sdbuf_rowinvalid[y]) {
+        b0 = 0;
+        b1 = sdbuf_stride - 1;
+        sdbuf_rowinvalid[y] = 0;
       }
+    }
 
-      if (serdisp_flag_bandpass) {
-        if (i >= (MAX_GREYVALUE - serdisp_flag_bandpass) ) 
-          i = MAX_GREYVALUE;
-        else if (i <= serdisp_flag_bandpass) 
-          i = 0;
+    if (b0 >= 0) {
+      if (run_y < 0) {
+        run_y = y;
+        run_b0 = b0;
+        run_b1 = b1;
+      } else {
+        if (b0 < run_b0) run_b0 = b0;
+        if (b1 > run_b1) run_b1 = b1;
       }
+    } else if (run_y >= 0) {
+      int x0 = run_b0 << sdbuf_xshift;
+      int x1 = (run_b1 + 1) << sdbuf_xshift;
+
+      if (x0 < sx) x0 = sx;
+      if (x1 > sx + w) x1 = sx + w;
+      sdbuf_output(buf, x0, run_y, x1 - x0, y - run_y);
+      run_y = -1;
+    }
+  }
+}
+
+
+/* *********************************
+   prog_budget()
+   *********************************
+   bytes that may be output per frame: option 'framebytes', else the bytes the display link transfers
+   in SD_PROG_LINKSHARE percent of the frame period (both measured)
+   *********************************
+   returns the budget in bytes, 0 if unlimited (not measured yet)
+   *********************************
+   --
+*/
+static unsigned long prog_budget(void) {
+  double rate;
+  int period;
+
+  if (serdisp_flag_framebytes > 0)
+    return serdisp_flag_framebytes;
+
+#if HAVE_PTHREADS
+  if (async_started)
+    pthread_mutex_lock(&async_mutex);
+#endif
+  rate = link_rate;
+  period = frame_periodus;
+#if HAVE_PTHREADS
+  if (async_started)
+    pthread_mutex_unlock(&async_mutex);
+#endif
+  if (rate <= 0.0 || period <= 0)
+    return 0;
+  return (unsigned long)(rate * period * SD_PROG_LINKSHARE / 100) + 1;
+}
+
+
+/* *********************************
+   prog_flush(buf)
+   *********************************
+   progressive update of a frame: outputs the row groups selected by sd_progselect() within the budget,
+   adjacent groups together
+   *********************************
+   buf    ... packed frame buffer
+   *********************************
+   --
+*/
+static void prog_flush(unsigned char* buf) {
+  prog_frame_t fr = { buf, sdbuf_prev, sdbuf_rowinvalid, sdbuf_diffpixels, sdbuf_stride, display_height };
+  int g, run_g = -1;
+
+  stat_progcarried += sd_progselect(&sd_prog, &fr, prog_budget());
+
+  /* output adjacent groups together */
+  prog_flushing = 1;
+  for (g = 0; g <= sd_prog.groups; g++) {
+    if (g < sd_prog.groups && sd_prog.send[g]) {
+      if (run_g < 0)
+        run_g = g;
+    } else if (run_g >= 0) {
+      int y0 = run_g * SD_PROG_ROWS, y1 = (g * SD_PROG_ROWS < display_height) ? g * SD_PROG_ROWS : display_height;
+
+      sdbuf_flush(buf, 0, y0, display_width, y1 - y0);
+      run_g = -1;
+    }
+  }
+  prog_flushing = 0;
+}
+
+
+/* *********************************
+   tone_build()
+   *********************************
+   builds the tone curve lookup tables from luma range, brightness/contrast, gamma, bandpass and threshold
+   *********************************
+   --
+*/
+static void tone_build(void) {
+  int i, v;
+
+  serdisp_flag_gamma_enable = (serdisp_flag_gamma > 0.0 && serdisp_flag_gamma != 1.0);
+  tone_identity = !serdisp_flag_gamma_enable && !serdisp_eq_brightness && !serdisp_eq_contrast && !image_lumaonly;
+
+  for (i = 0; i <= MAX_GREYVALUE; i++) {
+    v = i;
+    /* luma of yuv input: expand limited range [16, 235] to [0, 255] */
+    if (image_lumaonly) {
+      v = ((v - 16) * MAX_GREYVALUE + 109) / 219;
+      if (v < 0) v = 0;
+      if (v > MAX_GREYVALUE) v = MAX_GREYVALUE;
+    }
+
+    /* brightness / contrast */
+    v = (((v - 128) * (100 + serdisp_eq_contrast)) / 100) + 128 + (serdisp_eq_brightness * MAX_GREYVALUE) / 100;
+    if (v < 0) v = 0;
+    if (v > MAX_GREYVALUE) v = MAX_GREYVALUE;
+
+    if (serdisp_flag_gamma_enable) {
+      v = (int)(pow((double)v / 255.0, 1.0 / serdisp_flag_gamma) * 255.0);
+    }
+
+    /* direct drawing: threshold value (monochrome) or greyvalue matching (greyscale) */
+    if (image_colours == 2) {
+      tone_idxlut[i] = (v <= serdisp_flag_threshold) ? 0 : 1;
+    } else {
+      tone_idxlut[i] = grey2idx[v];
+    }
+
+    /* dithering: band pass filter */
+    if (serdisp_flag_bandpass && !istruecolour) {
+      if (v >= (MAX_GREYVALUE - serdisp_flag_bandpass) ) 
+        v = MAX_GREYVALUE;
+      else if (v <= serdisp_flag_bandpass) 
+        v = 0;
+    }
+    tone_lut[i] = v;
+  }
+
+  /* rgb565: all components of a pixel in one lookup */
+  if (tone_lut565 && !tone_identity) {
+    for (i = 0; i < 65536; i++) {
+      int r = (i >> 8) & 0xF8, g = (i >> 3) & 0xFC, b = (i << 3) & 0xF8;
+
+      r = tone_lut[r | (r >> 5)];
+      g = tone_lut[g | (g >> 6)];
+      b = tone_lut[b | (b >> 5)];
+      tone_lut565[i] = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+    }
+  }
+}
+
+
+#if HAVE_PTHREADS
+/* *********************************
+   pool_thread(arg) / pool_run(job)
+   *********************************
+   drawing thread: waits for jobs and runs them /
+   runs a job using all drawing threads (the calling thread takes part as thread 0) and waits until it is done
+   *********************************
+   job    ... function called by every thread with its number t and the number of threads n
+   *********************************
+   --
+*/
+static void* pool_thread(void* arg) {
+  int t = (int)(long)arg;
+  unsigned int jobid = 0;
+
+  pthread_mutex_lock(&pool_mutex);
+  for (;;) {
+    while (jobid == pool_jobid && !pool_quit)
+      pthread_cond_wait(&pool_cond, &pool_mutex);
+    if (pool_quit)
+      break;
+    jobid = pool_jobid;
+    pthread_mutex_unlock(&pool_mutex);
+
+    pool_job(t, pool_size);
+
+    pthread_mutex_lock(&pool_mutex);
+    if (--pool_busy == 0)
+      pthread_cond_broadcast(&pool_cond);
+  }
+  pthread_mutex_unlock(&pool_mutex);
+  return NULL;
+}
+
+static void pool_run(void (*job) (int t, int n)) {
+  pthread_mutex_lock(&pool_mutex);
+  pool_job = job;
+  pool_busy = pool_size - 1;
+  pool_jobid++;
+  pthread_cond_broadcast(&pool_cond);
+  pthread_mutex_unlock(&pool_mutex);
+
+  job(0, pool_size);
+
+  pthread_mutex_lock(&pool_mutex);
+  while (pool_busy)
+    pthread_cond_wait(&pool_cond, &pool_mutex);
+  pthread_mutex_unlock(&pool_mutex);
+}
+
+
+/* *********************************
+   fs_wait(t, value) / fs_publish(t, value)
+   *********************************
+   waits until thread t has reached a progress value / publishes the progress of thread t
+   *********************************
+   --
+*/
+static void fs_wait(int t, int value) {
+  pthread_mutex_lock(&pool_mutex);
+  while (fs_progress[t] < value)
+    pthread_cond_wait(&pool_cond, &pool_mutex);
+  pthread_mutex_unlock(&pool_mutex);
+}
+
+static void fs_publish(int t, int value) {
+  pthread_mutex_lock(&pool_mutex);
+  fs_progress[t] = value;
+  pthread_cond_broadcast(&pool_cond);
+  pthread_mutex_unlock(&pool_mutex);
+}
+#endif
+
+
+/* *********************************
+   dither_row_*(src, x0, x1, sx, y, errin, errout, errout2, slop)
+   *********************************
+   error diffusion of the pixels [x0, x1) of a row (floyd-steinberg, sierra lite, atkinson).
+   every kernel is generated for 2, 4 and 16 colours in native depth (threshold division and storing the
+   colour index are constant shifts, no branches in the inner loop) and for any other number of colours.
+   if quantisation factor * (colours - 1) doesn't reach MAX_GREYVALUE, the quantised grey value (not the index)
+   is clamped to MAX_GREYVALUE and mapped to the nearest colour index, like the original kernel did.
+   the quantisation error is never negative (threshold factor >= quantisation factor)
+   *********************************
+   src     ... grey values of the row (before applying the tone curve)
+   x0/x1   ... first pixel / pixel following the last one
+   sx/y    ... phys. position of the first pixel of the row
+   errin   ... errors of this row (may be identical to errout)
+   errout  ... output: errors for the row below
+   errout2 ... output: errors for the second row below (atkinson only)
+   slop    ... errors carried over to the next pixels, in/out
+   *********************************
+   --
+*/
+static inline void sdbuf_setidx_d(int x, int y, int idx, int dshift) {
+  int xshift = 3 - dshift;
+  unsigned char* p = sdbuf + y * sdbuf_stride + (x >> xshift);
+  int shift = ((~x) & ((1 << xshift) - 1)) << dshift;
+
+  *p = (*p & ~(((1 << (1 << dshift)) - 1) << shift)) | (idx << shift);
+}
+
+/* lc: log2 of the number of colours (0: any number of colours) */
+#define SD_DITHER_PROLOGUE(lc)                                                                  \
+  const int colours = (lc) ? (1 << (lc)) : image_colours;                                      \
+  const unsigned int thr = ((MAX_GREYVALUE + 1) * 2) / colours;  /* threshold factor */         \
+  const int q = MAX_GREYVALUE / (colours - 1);                   /* quantisation factor */      \
+  const int dshift = (lc) ? (((lc) == 4) ? 2 : (lc) - 1) : sdbuf_dshift;                         \
+  int x, i, k, idx
+
+#define SD_DITHER_QUANTISE                                                                      \
+    idx = (unsigned int)i / thr;                                                                \
+    if (q * (colours - 1) == MAX_GREYVALUE) {   /* constant for 2, 4 and 16 colours */          \
+      idx = (idx < colours) ? idx : colours - 1;                                                \
+      sdbuf_setidx_d(x+sx, y, idx, dshift);                                                     \
+      i -= idx * q;                                                                             \
+    } else {                                                                                    \
+      int v = idx * q;                                                                          \
+      v = (v < MAX_GREYVALUE) ? v : MAX_GREYVALUE;                                              \
+      sdbuf_setidx_d(x+sx, y, grey2idx[v], dshift);                                             \
+      i -= v;                                                                                   \
+    }
+
+/* hysteresis: the index of the last frame is kept while the grey value stays within the margin.
+   the error left is clamped to [0, threshold factor - 1], the range of an unforced quantisation: the kernels
+   rely on errors never being negative, so the part of the error caused by keeping an index is not diffused */
+#define SD_DITHER_QUANTISE_STABLE                                                               \
+    {                                                                                           \
+      int p = y * display_width + x + sx, g = tone_lut[src[x]], v;                              \
+                                                                                                \
+      idx = (unsigned int)i / thr;                                                              \
+      if (q * (colours - 1) == MAX_GREYVALUE) {   /* constant for 2, 4 and 16 colours */        \
+        idx = (idx < colours) ? idx : colours - 1;                                              \
+        v = idx * q;                                                                            \
+      } else {                                                                                  \
+        v = idx * q;                                                                            \
+        v = (v < MAX_GREYVALUE) ? v : MAX_GREYVALUE;                                            \
+        idx = grey2idx[v];                                                                      \
+      }                                                                                         \
+      if (abs(g - stab_ref[p]) > serdisp_flag_hysteresis) {                                     \
+        stab_ref[p] = g;                                                                        \
+        stab_idx[p] = idx;                                                                      \
+      } else if (stab_idx[p] != idx) {                                                          \
+        idx = stab_idx[p];                                                                      \
+        v = (q * (colours - 1) == MAX_GREYVALUE) ? idx * q : idx2grey[idx];                     \
+      }                                                                                         \
+      sdbuf_setidx_d(x+sx, y, idx, dshift);                                                     \
+      i -= v;                                                                                   \
+      i = (i < 0) ? 0 : ((i < (int)thr) ? i : (int)thr - 1);                                    \
+    }
+
+/* floyd-steinberg: 7/16 right, 3/16 below left, 5/16 below, 1/16 below right (remainder) */
+#define SD_DITHER_FS(name, lc, quantise)                                                                 \
+static void name(const unsigned char* src, int x0, int x1, int sx, int y,                       \
+                 const int* errin, int* errout, int* errout2, int* slop) {                      \
+  SD_DITHER_PROLOGUE(lc);                                                                       \
+  int xslop = slop[0], dslop = slop[1];                                                         \
+                                                                                                \
+  for (x = x0; x < x1; x++) {                                                                   \
+    i = tone_lut[src[x]] + xslop + errin[x];                                                    \
+    quantise;                                                                                   \
+    k = i >> 4;                                                                                 \
+    xslop = 7 * k;                                                                              \
+    errout[x] = (5 * k) + dslop;                                                                \
+    errout[x-1] += 3 * k;                                                                       \
+    dslop = i - (15 * k);                                                                       \
+  }                                                                                             \
+  slop[0] = xslop;                                                                              \
+  slop[1] = dslop;                                                                              \
+}
+
+/* sierra lite: 2/4 right (incl. remainder), 1/4 below left, 1/4 below */
+#define SD_DITHER_SIERRALITE(name, lc, quantise)                                                         \
+static void name(const unsigned char* src, int x0, int x1, int sx, int y,                       \
+                 const int* errin, int* errout, int* errout2, int* slop) {                      \
+  SD_DITHER_PROLOGUE(lc);                                                                       \
+  int xslop = slop[0];                                                                          \
+                                                                                                \
+  for (x = x0; x < x1; x++) {                                                                   \
+    i = tone_lut[src[x]] + xslop + errin[x];                                                    \
+    quantise;                                                                                   \
+    k = i >> 2;                                                                                 \
+    xslop = i - (2 * k);                                                                        \
+    errout[x] = k;                                                                              \
+    errout[x-1] += k;                                                                           \
+  }                                                                                             \
+  slop[0] = xslop;                                                                              \
+}
+
+/* atkinson: 1/8 to the two pixels right, the three pixels below and the pixel two rows below
+   (only 3/4 of the error is diffused) */
+#define SD_DITHER_ATKINSON(name, lc, quantise)                                                           \
+static void name(const unsigned char* src, int x0, int x1, int sx, int y,                       \
+                 const int* errin, int* errout, int* errout2, int* slop) {                      \
+  SD_DITHER_PROLOGUE(lc);                                                                       \
+  int xslop = slop[0], xslop2 = slop[1];                                                        \
+                                                                                                \
+  for (x = x0; x < x1; x++) {                                                                   \
+    i = tone_lut[src[x]] + xslop + errin[x];                                                    \
+    quantise;                                                                                   \
+    k = i >> 3;                                                                                 \
+    xslop = xslop2 + k;                                                                         \
+    xslop2 = k;                                                                                 \
+    errout[x-1] += k;                                                                           \
+    errout[x] += k;                                                                             \
+    errout[x+1] += k;                                                                           \
+    errout2[x] = k;                                                                             \
+  }                                                                                             \
+  slop[0] = xslop;                                                                              \
+  slop[1] = xslop2;                                                                             \
+}
+
+SD_DITHER_FS(dither_row_fs_2, 1, SD_DITHER_QUANTISE)
+SD_DITHER_FS(dither_row_fs_4, 2, SD_DITHER_QUANTISE)
+SD_DITHER_FS(dither_row_fs_16, 4, SD_DITHER_QUANTISE)
+SD_DITHER_FS(dither_row_fs_n, 0, SD_DITHER_QUANTISE)
+SD_DITHER_FS(dither_row_fs_stable_2, 1, SD_DITHER_QUANTISE_STABLE)
+SD_DITHER_FS(dither_row_fs_stable_4, 2, SD_DITHER_QUANTISE_STABLE)
+SD_DITHER_FS(dither_row_fs_stable_16, 4, SD_DITHER_QUANTISE_STABLE)
+SD_DITHER_FS(dither_row_fs_stable_n, 0, SD_DITHER_QUANTISE_STABLE)
+SD_DITHER_SIERRALITE(dither_row_sierralite_2, 1, SD_DITHER_QUANTISE)
+SD_DITHER_SIERRALITE(dither_row_sierralite_4, 2, SD_DITHER_QUANTISE)
+SD_DITHER_SIERRALITE(dither_row_sierralite_16, 4, SD_DITHER_QUANTISE)
+SD_DITHER_SIERRALITE(dither_row_sierralite_n, 0, SD_DITHER_QUANTISE)
+SD_DITHER_SIERRALITE(dither_row_sierralite_stable_2, 1, SD_DITHER_QUANTISE_STABLE)
+SD_DITHER_SIERRALITE(dither_row_sierralite_stable_4, 2, SD_DITHER_QUANTISE_STABLE)
+SD_DITHER_SIERRALITE(dither_row_sierralite_stable_16, 4, SD_DITHER_QUANTISE_STABLE)
+SD_DITHER_SIERRALITE(dither_row_sierralite_stable_n, 0, SD_DITHER_QUANTISE_STABLE)
+SD_DITHER_ATKINSON(dither_row_atkinson_2, 1, SD_DITHER_QUANTISE)
+SD_DITHER_ATKINSON(dither_row_atkinson_4, 2, SD_DITHER_QUANTISE)
+SD_DITHER_ATKINSON(dither_row_atkinson_16, 4, SD_DITHER_QUANTISE)
+SD_DITHER_ATKINSON(dither_row_atkinson_n, 0, SD_DITHER_QUANTISE)
+SD_DITHER_ATKINSON(dither_row_atkinson_stable_2, 1, SD_DITHER_QUANTISE_STABLE)
+SD_DITHER_ATKINSON(dither_row_atkinson_stable_4, 2, SD_DITHER_QUANTISE_STABLE)
+SD_DITHER_ATKINSON(dither_row_atkinson_stable_16, 4, SD_DITHER_QUANTISE_STABLE)
+SD_DITHER_ATKINSON(dither_row_atkinson_stable_n, 0, SD_DITHER_QUANTISE_STABLE)
+
+typedef void (*dither_row_t) (const unsigned char* src, int x0, int x1, int sx, int y,
+                              const int* errin, int* errout, int* errout2, int* slop);
+
+/* error diffusion kernels (option 'diffusion') */
+static const struct {
+  const char*   name;
+  int           rows;        /* rows the error is diffused to (1: rows may be dithered as a wavefront) */
+  int           errinit;     /* errors of the first row */
+  int           slop[2];     /* errors carried over to the first pixels of a row */
+  dither_row_t  row[4];      /* 2, 4, 16 colours (native depth), any other number of colours */
+  dither_row_t  stable[4];   /* with hysteresis (same variants) */
+} dither_kernels[] = {
+  { "floyd steinberg", 1, (9 * MAX_GREYVALUE) / 32, { (7 * MAX_GREYVALUE) / 32, MAX_GREYVALUE / 32 },
+    { dither_row_fs_2, dither_row_fs_4, dither_row_fs_16, dither_row_fs_n },
+    { dither_row_fs_stable_2, dither_row_fs_stable_4, dither_row_fs_stable_16, dither_row_fs_stable_n } },
+  { "sierra lite",     1, 0, { 0, 0 },
+    { dither_row_sierralite_2, dither_row_sierralite_4, dither_row_sierralite_16, dither_row_sierralite_n },
+    { dither_row_sierralite_stable_2, dither_row_sierralite_stable_4, dither_row_sierralite_stable_16,
+      dither_row_sierralite_stable_n } },
+  { "atkinson",        2, 0, { 0, 0 },
+    { dither_row_atkinson_2, dither_row_atkinson_4, dither_row_atkinson_16, dither_row_atkinson_n },
+    { dither_row_atkinson_stable_2, dither_row_atkinson_stable_4, dither_row_atkinson_stable_16,
+      dither_row_atkinson_stable_n } }
+};
+static dither_row_t dither_row;    /* variant selected for kernel and number of colours */
 
-      i += xslop + yslop[x];
-      j = (i / t) *q;
-      if (j > MAX_GREYVALUE) 
-        j = MAX_GREYVALUE;   /* should never occur (but to be sure ...) */
 
-      fp_serdisp_setsdgrey(dd, x+sx, y+sy, j);
+/* *********************************
+   fs_rowbuffers(y, first, n, w, errin, errout, errout2)
+   *********************************
+   gets the error buffers of row y: one-row kernels read the buffer of row y-1 (or the initial errors)
+   and write buffer y % n (updated in place with one thread), atkinson uses three buffers round robin
+   *********************************
+   y      ... phys. row
+   first  ... first row of a frame (errors are reset)
+   n      ... number of threads
+   w      ... width of row
+   *********************************
+   --
+*/
+static void fs_rowbuffers(int y, int first, int n, int w, const int** errin, int** errout, int** errout2) {
+  if (dither_kernels[serdisp_flag_diffusion].rows == 1) {
+    *errin = (first) ? fs_errinit : fs_err[(y-1) % n];
+    *errout = fs_err[y % n];
+    *errout2 = NULL;
+  } else {
+    if (first) {
+      memset(fs_err[y % 3], 0, w * sizeof(int));
+      memset(fs_err[(y+1) % 3] - 1, 0, (w + 2) * sizeof(int));
+    }
+    *errin = fs_err[y % 3];
+    *errout = fs_err[(y+1) % 3];
+    *errout2 = fs_err[(y+2) % 3];
+  }
+}
 
-      i = i - j;
-      k = (i >> 4);
-      xslop = 7 * k;
-      yslop[x] = (5*k) + dslop;
-      if (x > 0)
-        yslop[x-1] += 3 * k;
 
-      dslop = i - (15 * k);
+/* *********************************
+   fs_dorows(t, n)
+   *********************************
+   error diffusion dithering of the rows y (phys. row) of fs_job with y % n == t.
+   with n > 1 the rows are dithered as a skewed wavefront: a chunk of row y is started only after
+   row y-1 has been dithered one pixel beyond it, so the errors read are final and the result is
+   identical to dithering the rows one after another.
+   if the area continues the one dithered before, the errors of its last row are used for the first row
+   *********************************
+   t      ... thread number
+   n      ... number of threads
+   *********************************
+   --
+*/
+static void fs_dorows(int t, int n) {
+  int x0, x1, y, first;
+  int slop[2];
+  int w = fs_job.w;
+  const int* errin;
+  int* errout;
+  int* errout2;
+  const unsigned char* src;
+
+  for (y = fs_job.sy + (t - fs_job.sy % n + n) % n; y < fs_job.sy + fs_job.h; y += n) {
+    first = (y == fs_job.sy);
+    fs_rowbuffers(y, first && !fs_job.cont, n, w, &errin, &errout, &errout2);
+    src = fs_job.src + (y - fs_job.sy) * image_stride[0];
+
+    slop[0] = dither_kernels[serdisp_flag_diffusion].slop[0];
+    slop[1] = dither_kernels[serdisp_flag_diffusion].slop[1];
+
+    for (x0 = 0; x0 < w; x0 = x1) {
+      x1 = (n > 1 && x0 + SD_FS_CHUNK < w) ? x0 + SD_FS_CHUNK : w;
+#if HAVE_PTHREADS
+      if (n > 1 && !first)   /* row before the first one has been completed by the previous call */
+        fs_wait((y-1) % n, (y-1) * (w+1) + ((x1 < w) ? x1 + 1 : w));
+#endif
+      dither_row(src, x0, x1, fs_job.sx, y, errin, errout, errout2, slop);
+#if HAVE_PTHREADS
+      if (n > 1)
+        fs_publish(y % n, y * (w+1) + x1);
+#endif
     }
   }
 }
 
 
 /* *********************************
-   drawingalgo_directgrey(image, sx, sy, w, h)
+   fs_stablereset()
+   *********************************
+   forgets the indices chosen by stable error diffusion (new geometry: every pixel is dithered again)
+   *********************************
+   --
+*/
+static void fs_stablereset(void) {
+  int p;
+
+  if (!stab_ref)
+    return;
+  for (p = 0; p < display_width * display_height; p++)
+    stab_ref[p] = -(MAX_GREYVALUE + 1);
+}
+
+
+/* *********************************
+   fs_init()
+   *********************************
+   allocates the error buffers for error diffusion dithering (one per drawing thread, at least three)
+   and selects the kernel variant for the number of colours (with hysteresis: the stable variant and its buffers)
+   *********************************
+   returns 0 if successful, else -1
+   *********************************
+   --
+*/
+static int fs_init(void) {
+  int t, x, v;
+  int nbufs = (pool_size > 3) ? pool_size : 3;
+  int* buf;
+
+  if (serdisp_flag_diffusion < 0 || serdisp_flag_diffusion > 2)
+    serdisp_flag_diffusion = 0;
+
+  fs_errinit = (int*)malloc(display_width * sizeof(int));
+  if (!fs_errinit)
+    return -1;
+  for (x = 0; x < display_width; x++)
+    fs_errinit[x] = dither_kernels[serdisp_flag_diffusion].errinit;
+
+  for (t = 0; t < nbufs; t++) {
+    buf = (int*)calloc(display_width + 2, sizeof(int));
+    if (!buf)
+      return -1;
+    fs_err[t] = buf + 1;  /* guard elements */
+  }
+
+  if (image_colours == 2 && sdbuf_depth == 1)
+    v = 0;
+  else if (image_colours == 4 && sdbuf_depth == 2)
+    v = 1;
+  else if (image_colours == 16 && sdbuf_depth == 4)
+    v = 2;
+  else
+    v = 3;
+  dither_row = dither_kernels[serdisp_flag_diffusion].row[v];
+
+  if (serdisp_flag_hysteresis > 0) {
+    if (serdisp_flag_hysteresis > MAX_GREYVALUE)
+      serdisp_flag_hysteresis = MAX_GREYVALUE;
+    stab_ref = (short*)malloc(display_width * display_height * sizeof(short));
+    stab_idx = (unsigned char*)malloc(display_width * display_height);
+    if (!stab_ref || !stab_idx)
+      return -1;
+    fs_stablereset();
+    dither_row = dither_kernels[serdisp_flag_diffusion].stable[v];
+  }
+  return 0;
+}
+
+
+/* *********************************
+   drawingalgo_dithergrey(image, sx, sy, w, h)
    *********************************
-   draws a frame without using dithering
+   dithers a frame or slice on a monochrome/greyscale display using error diffusion (option 'diffusion')
+   (one-row kernels using all drawing threads, drawn into the packed frame buffer which is then output using sdbuf_flush()).
+   the dithering errors are carried over from one slice of a frame to the next one
    *********************************
    image  ... mplayer frame
    sx/sy  ... phys. start position
@@ -337,85 +1278,1885 @@ static void drawingalgo_dithergrey(unsigned char** image, int sx, int sy, int w,
    *********************************
    --
 */
-static void drawingalgo_directgrey(unsigned char** image, int sx, int sy, int w, int h) {
-  int x, y;
-  int i;
-  double f = 0.0;
+static void drawingalgo_dithergrey(unsigned char** image, int sx, int sy, int w, int h) {
+  fs_job.cont = (sy == fs_nexty && sx == fs_job.sx && w == fs_job.w);
+  fs_nexty = sy + h;
+  fs_job.src = image[0] + (sx-screen_x) + (sy-screen_y) * image_stride[0];
+  fs_job.sx = sx;
+  fs_job.sy = sy;
+  fs_job.w = w;
+  fs_job.h = h;
+
+#if HAVE_PTHREADS
+  if (pool_size > 1 && dither_kernels[serdisp_flag_diffusion].rows == 1) {
+    int t;
+
+    for (t = 0; t < pool_size; t++)
+      fs_progress[t] = -1;
+    pool_run(fs_dorows);
+  } else
+#endif
+    fs_dorows(0, 1);
 
-  unsigned char* buffer = image[0];
+  if (!serdisp_flag_async)
+    sdbuf_flush(sdbuf, sx, sy, w, h);
+}
 
-  for (y = 0; y < h; y++) {
-    for (x = 0; x < w; x++) {
-      i = buffer[x+(sx-screen_x)  +  (y+(sy-screen_y)) * image_width];
 
-      if (serdisp_flag_gamma_enable) {
-        f = pow((double)i / 255.0, 1.0 / serdisp_flag_gamma);
+/* *********************************
+   sdbuf_putrow(x, y, idx, w)
+   *********************************
+   stores a row of colour indices in the packed frame buffer that is currently drawn into
+   *********************************
+   x/y    ... phys. start position
+   idx    ... colour indices
+   w      ... number of pixels
+   *********************************
+   --
+*/
+static void sdbuf_putrow(int x, int y, const unsigned char* idx, int w) {
+  int i, b, ppb = sdbuf_xmask + 1;
+  unsigned char* p;
+
+  /* leading pixels not starting at a byte boundary */
+  for (; w > 0 && (x & sdbuf_xmask); x++, w--)
+    sdbuf_setidx(x, y, *idx++);
+
+  p = sdbuf + y * sdbuf_stride + (x >> sdbuf_xshift);
+  for (; w >= ppb; x += ppb, w -= ppb) {
+    for (b = 0, i = 0; i < ppb; i++)
+      b = (b << sdbuf_depth) | *idx++;
+    *p++ = b;
+  }
 
-        i = (int)(f * 255.0);
-      }
+  for (; w > 0; x++, w--)
+    sdbuf_setidx(x, y, *idx++);
+}
 
-      /* if monochrome-display: consider threshold value (default value: 127) */
-      if (image_colours == 2) {
-        fp_serdisp_setsdgrey(dd, x+sx, y+sy, ((i <= serdisp_flag_threshold) ? 0 : MAX_GREYVALUE) );
-      } else {
-        fp_serdisp_setsdgrey(dd, x+sx, y+sy, i);  /* let serdisplib do the greyvalue matching if greyscale display */
-      }
-    }
+
+/* *********************************
+   ordered_init()
+   *********************************
+   generates the threshold matrix selected by option 'matrix', tiles it to display width
+   and selects the quantisation kernel
+   *********************************
+   returns 0 if successful, else -1
+   *********************************
+   --
+*/
+static int ordered_init(void) {
+  int rank[SD_ORDERED_MAXSIZE * SD_ORDERED_MAXSIZE];
+  int x, y;
+
+  switch (serdisp_flag_matrix) {
+    case 0:
+      ordered_size = 4;
+      sd_orderedbayer(rank, ordered_size);
+      break;
+    case 2:
+      ordered_size = SD_ORDERED_MAXSIZE;
+      sd_orderedbluenoise(rank, ordered_size);
+      break;
+    default:
+      ordered_size = 8;
+      sd_orderedbayer(rank, ordered_size);
+  }
+
+  ordered_thr = (unsigned char*)malloc(ordered_size * display_width);
+  ordered_line = (unsigned char*)malloc((display_width + 16) * pool_size);   /* one line per drawing thread */
+  if (!ordered_thr || !ordered_line)
+    return -1;
+
+  /* thresholds are centred in their interval and tiled using phys. positions (pattern doesn't move) */
+  for (y = 0; y < ordered_size; y++)
+    for (x = 0; x < display_width; x++)
+      ordered_thr[y * display_width + x] = SD_ORDERED_THR(rank[y * ordered_size + (x % ordered_size)], ordered_size);
+
+  ordered_quantise = sd_orderedquantise_c;
+  ordered_kernelname = "C";
+#ifdef SD_ORDERED_SSE2
+  if (gCpuCaps.hasSSE2) {
+    ordered_quantise = sd_orderedquantise_sse2;
+    ordered_kernelname = "SSE2";
+  }
+#endif
+#if HAVE_NEON
+  ordered_quantise = sd_orderedquantise_neon;
+  ordered_kernelname = "NEON";
+#endif
+  return 0;
+}
+
+
+/* *********************************
+   ordered_rows(image, sx, sy, w, h, line) / drawingalgo_ordered(image, sx, sy, w, h)
+   *********************************
+   dithers a frame on a monochrome/greyscale display using ordered dithering (threshold matrix)
+   into the packed frame buffer / and outputs it using sdbuf_flush()
+   *********************************
+   image  ... mplayer frame
+   sx/sy  ... phys. start position
+   w/h    ... width/height of frame
+   line   ... line buffer (display_width + 16 bytes)
+   *********************************
+   --
+*/
+static void ordered_rows(unsigned char** image, int sx, int sy, int w, int h, unsigned char* line) {
+  int x, y;
+  const unsigned char* src;
+
+  unsigned char* buffer = image[0];
+
+  for (y = 0; y < h; y++) {
+    src = buffer + (sx-screen_x) + (y+(sy-screen_y)) * image_stride[0];
+
+    if (!tone_identity) {
+      for (x = 0; x < w; x++)
+        line[x] = tone_lut[src[x]];
+      src = line;
+    }
+    ordered_quantise(line, src, ordered_thr + ((y+sy) % ordered_size) * display_width + sx, w, image_colours - 1);
+    sdbuf_putrow(sx, y+sy, line, w);
+  }
+}
+
+static void drawingalgo_ordered(unsigned char** image, int sx, int sy, int w, int h) {
+  ordered_rows(image, sx, sy, w, h, ordered_line);
+  if (!serdisp_flag_async)
+    sdbuf_flush(sdbuf, sx, sy, w, h);
+}
+
+
+/* *********************************
+   directgrey_rows(image, sx, sy, w, h) / drawingalgo_directgrey(image, sx, sy, w, h)
+   *********************************
+   draws a frame without using dithering into the packed frame buffer / and outputs it using sdbuf_flush()
+   *********************************
+   image  ... mplayer frame
+   sx/sy  ... phys. start position
+   w/h    ... width/height of frame
+   *********************************
+   --
+*/
+static void directgrey_rows(unsigned char** image, int sx, int sy, int w, int h) {
+  int x, y;
+
+  unsigned char* buffer = image[0];
+
+  for (y = 0; y < h; y++) {
+    for (x = 0; x < w; x++) {
+      /* tone curve and threshold (monochrome) / greyvalue matching (greyscale) in one step */
+      sdbuf_setidx(x+sx, y+sy, tone_idxlut[buffer[x+(sx-screen_x)  +  (y+(sy-screen_y)) * image_stride[0]]]);
+    }
+  }
+}
+
+static void drawingalgo_directgrey(unsigned char** image, int sx, int sy, int w, int h) {
+  directgrey_rows(image, sx, sy, w, h);
+  if (!serdisp_flag_async)
+    sdbuf_flush(sdbuf, sx, sy, w, h);
+}
+
+
+/* *********************************
+   rot_frame(src, stride, sx, sy, w, h)
+   *********************************
+   pre-rotation: rotates an area of a scaled frame (video orientation) into image[0] (display orientation)
+   *********************************
+   src    ... scaled frame (image_width x image_height, image_bpp bytes per pixel)
+   stride ... bytes per row of src
+   sx/sy  ... phys. start position
+   w/h    ... width/height of area
+   *********************************
+   --
+*/
+static void rot_frame(const unsigned char* src, int stride, int sx, int sy, int w, int h) {
+  sd_rotate(image[0], image_stride[0], src, stride, image_width, image_height, image_bpp, rot_mode,
+            sx - screen_x, sy - screen_y, w, h);
+}
+
+
+/* *********************************
+   drawing_clip(sx, sy, w, h)
+   *********************************
+   clips an area to the display (viewmode 1 and 2 may scale the frame beyond the display borders)
+   *********************************
+   sx/sy  ... phys. start position (in/out)
+   w/h    ... width/height of area (in/out)
+   *********************************
+   returns 0 if nothing of the area is visible, else 1
+   *********************************
+   --
+*/
+static int drawing_clip(int* sx, int* sy, int* w, int* h) {
+  if (*sx < 0) { *w += *sx; *sx = 0; }
+  if (*sy < 0) { *h += *sy; *sy = 0; }
+  if (*sx + *w > display_width)  *w = display_width - *sx;
+  if (*sy + *h > display_height) *h = display_height - *sy;
+
+  return (*w > 0 && *h > 0);
+}
+
+
+/* *********************************
+   drawing_rotated(src, stride)
+   *********************************
+   pre-rotation: rotates the visible part of a complete scaled frame into display orientation and draws it.
+   (slices are rows of the video, they become columns or are reversed: frames are drawn once complete)
+   *********************************
+   src    ... scaled frame (video orientation)
+   stride ... bytes per row of src
+   *********************************
+   --
+*/
+static void drawing_rotated(const unsigned char* src, int stride) {
+  int sx = screen_x, sy = screen_y, w = screen_w, h = screen_h;
+
+  if (drawing_clip(&sx, &sy, &w, &h)) {
+    rot_frame(src, stride, sx, sy, w, h);
+    drawing_algo(image, sx, sy, w, h);
+  }
+}
+
+
+/* *********************************
+   fused_free() / fused_init()
+   *********************************
+   frees the buffers of the fused downscaling pipeline /
+   enables it (and allocates its buffers) if the luma plane is downscaled by at least SD_FUSED_RATIO
+   and the frame fits into the display
+   *********************************
+   --
+*/
+static void fused_free(void) {
+  if (fused_acc) {
+    free(fused_acc);
+    fused_acc = NULL;
+  }
+  if (fused_x0) {
+    free(fused_x0);
+    fused_x0 = NULL;
+  }
+  if (fused_line) {
+    free(fused_line);
+    fused_line = NULL;
+  }
+  fused_enabled = 0;
+}
+
+static void fused_init(void) {
+  int x;
+
+  fused_free();
+  if (!image_lumaonly || src_width < SD_FUSED_RATIO * image_width || src_height < SD_FUSED_RATIO * image_height ||
+      screen_x < 0 || screen_y < 0 || screen_x + screen_w > display_width || screen_y + screen_h > display_height)
+    return;
+
+  fused_acc = (int*)calloc(image_width, sizeof(int));
+  fused_x0 = (int*)malloc((image_width + 1) * sizeof(int));
+  fused_line = (unsigned char*)malloc(image_width + 16);
+  if (!fused_acc || !fused_x0 || !fused_line) {
+    mp_msg(MSGT_VO,MSGL_WARN,"vo_serdisp: unable to allocate buffers for fused downscaling, using sws\n");
+    fused_free();
+    return;
+  }
+  for (x = 0; x <= image_width; x++)
+    fused_x0[x] = (x * src_width) / image_width;
+
+  fused_srcy = 0;
+  fused_outy = 0;
+  fused_enabled = 1;
+}
+
+
+/* *********************************
+   fused_emitrow(y)
+   *********************************
+   tone maps and quantises/dithers the area averages in fused_line into phys. row y
+   using the drawing algorithm selected by option 'dither'
+   *********************************
+   --
+*/
+static void fused_emitrow(int y) {
+  int x;
+
+  switch (serdisp_flag_algo) {
+    case 0:
+      for (x = 0; x < image_width; x++)
+        fused_line[x] = tone_idxlut[fused_line[x]];
+      sdbuf_putrow(screen_x, y, fused_line, image_width);
+      break;
+    case 2:
+      if (!tone_identity) {
+        for (x = 0; x < image_width; x++)
+          fused_line[x] = tone_lut[fused_line[x]];
+      }
+      ordered_quantise(fused_line, fused_line, ordered_thr + (y % ordered_size) * display_width + screen_x, image_width, image_colours - 1);
+      sdbuf_putrow(screen_x, y, fused_line, image_width);
+      break;
+    default: {
+      const int* errin;
+      int* errout;
+      int* errout2;
+      int slop[2];
+
+      /* one row after the other: error buffers as used by one thread */
+      slop[0] = dither_kernels[serdisp_flag_diffusion].slop[0];
+      slop[1] = dither_kernels[serdisp_flag_diffusion].slop[1];
+      fs_rowbuffers(y, (y == screen_y), 1, image_width, &errin, &errout, &errout2);
+      dither_row(fused_line, 0, image_width, screen_x, y, errin, errout, errout2, slop);
+    }
+  }
+}
+
+
+/* *********************************
+   fused_rows(src, stride, y, h)
+   *********************************
+   fused downscaling: accumulates source rows and outputs every output row as soon as
+   all its source rows have been accumulated (frames may be passed in slices)
+   *********************************
+   src    ... luma plane of the first source row
+   stride ... stride of luma plane
+   y/h    ... first source row / number of rows
+   *********************************
+   --
+*/
+static void fused_rows(const unsigned char* src, int stride, int y, int h) {
+  int x, i, sum, sy, rows, firsty = -1;
+  int endy = ((fused_outy + 1) * src_height) / image_height;   /* source row following the current output row */
+
+  if (y == 0) {
+    memset(fused_acc, 0, image_width * sizeof(int));
+    fused_srcy = 0;
+    fused_outy = 0;
+    endy = src_height / image_height;
+  }
+  if (y != fused_srcy)   /* slices out of order */
+    return;
+
+  for (sy = y; sy < y + h && fused_outy < image_height; sy++, src += stride) {
+    /* column sums */
+    for (x = 0, i = 0; x < image_width; x++) {
+      for (sum = 0; i < fused_x0[x+1]; i++)
+        sum += src[i];
+      fused_acc[x] += sum;
+    }
+
+    if (sy + 1 == endy) {
+      rows = endy - (fused_outy * src_height) / image_height;
+      for (x = 0; x < image_width; x++) {
+        fused_line[x] = fused_acc[x] / ((fused_x0[x+1] - fused_x0[x]) * rows);
+        fused_acc[x] = 0;
+      }
+      if (rot_mode) {
+        /* pre-rotation: the frame is rotated and drawn once complete */
+        memcpy(rot_scaled + fused_outy * image_scaledstride[0], fused_line, image_width);
+      } else {
+        if (firsty < 0)
+          firsty = screen_y + fused_outy;
+        fused_emitrow(screen_y + fused_outy);
+      }
+      fused_outy++;
+      endy = ((fused_outy + 1) * src_height) / image_height;
+    }
+  }
+  fused_srcy = y + h;
+
+  if (rot_mode && fused_outy == image_height && y + h >= src_height) {
+    fs_nexty = -1;
+    drawing_rotated(rot_scaled, image_scaledstride[0]);
+  }
+
+  if (firsty >= 0 && !serdisp_flag_async)
+    sdbuf_flush(sdbuf, screen_x, firsty, image_width, screen_y + fused_outy - firsty);
+}
+
+
+/* *********************************
+   truecolour_tone(buffer, sx, sy, w, h)
+   *********************************
+   applies the tone curve to all colour components of an area of a truecolour frame
+   *********************************
+   buffer ... frame (display geometry, rgb24 or rgb565)
+   sx/sy  ... phys. start position
+   w/h    ... width/height of area
+   *********************************
+   --
+*/
+static void truecolour_tone(unsigned char* buffer, int sx, int sy, int w, int h) {
+  int x, y;
+  unsigned char* p;
+
+  if (tone_identity || tc_dither)   /* dithering: tone curve has been applied by truecolour_stage() */
+    return;
+
+  for (y = 0; y < h; y++) {
+    p = buffer + (sx + (y + sy) * display_width) * tc_bpp;
+    if (tc_bpp == 2) {
+      uint16_t* q = (uint16_t*)p;
+
+      for (x = 0; x < w; x++)
+        q[x] = tone_lut565[q[x]];
+    } else {
+      for (x = 0; x < w * 3; x++) {
+        p[x] = tone_lut[p[x]];
+      }
+    }
+  }
+}
+
+
+/* *********************************
+   truecolour_getcol(p) / truecolour_putcol(p, col)
+   *********************************
+   reads / writes a pixel of a truecolour frame (rgb24 or rgb565)
+   *********************************
+   p      ... pixel
+   col    ... colour (0xAARRGGBB)
+   *********************************
+   --
+*/
+static inline uint32_t truecolour_getcol(const unsigned char* p) {
+  if (tc_bpp == 2) {
+    unsigned int v = *(const uint16_t*)p;
+    unsigned int r = (v >> 8) & 0xF8, g = (v >> 3) & 0xFC, b = (v << 3) & 0xF8;
+
+    return 0xFF000000 | ((r | (r >> 5)) << 16) | ((g | (g >> 6)) << 8) | (b | (b >> 5));
+  }
+  return 0xFF000000 | (p[0] << 16) | (p[1] << 8) | p[2];
+}
+
+static inline void truecolour_putcol(unsigned char* p, uint32_t col) {
+  if (tc_bpp == 2) {
+    *(uint16_t*)p = (((col >> 19) & 0x1F) << 11) | (((col >> 10) & 0x3F) << 5) | ((col >> 3) & 0x1F);
+  } else {
+    p[0] = (col >> 16) & 0xFF;
+    p[1] = (col >> 8) & 0xFF;
+    p[2] = col & 0xFF;
+  }
+}
+
+
+/* *********************************
+   truecolour_output(buffer, sx, sy, w, h)
+   *********************************
+   outputs an area of a truecolour frame.
+   if serdisp_cliparea() may be used, the full display rows of the area are transferred using one call
+   (borders: background colour), else the area is drawn pixel by pixel
+   *********************************
+   buffer ... frame (display geometry, rgb24 or rgb565)
+   sx/sy  ... phys. start position
+   w/h    ... width/height of area
+   *********************************
+   --
+*/
+static void truecolour_output(unsigned char* buffer, int sx, int sy, int w, int h) {
+  int x, y;
+  unsigned char* p;
+
+  if (isclipareasave) {
+    /* inpmode: 24: rgb24, 16: rgb565 (one 16 bit word per pixel) */
+    sd_cliparea(&sd_out, 0, sy, display_width, h, 0, sy, display_width, display_height, tc_bpp * 8, buffer);
+    w = display_width;
+  } else {
+    for (y = sy; y < sy + h; y++) {
+      p = buffer + (y * display_width + sx) * tc_bpp;
+      for (x = sx; x < sx + w; x++, p += tc_bpp) {
+        sd_setsdcol(&sd_out, x, y, truecolour_getcol(p));
+      }
+    }
+  }
+  frame_bytes += (w * h * display_depth + 7) >> 3;
+  frame_drawnpixels += w * h;
+  frame_changedpixels += w * h;   /* no dirty-region tracking for truecolour displays */
+}
+
+
+/* *********************************
+   truecolour_clear(buffer)
+   *********************************
+   fills a truecolour frame (display geometry) with the background colour
+   *********************************
+   buffer ... frame (rgb24 or rgb565)
+   *********************************
+   --
+*/
+static void truecolour_clear(unsigned char* buffer) {
+  int i;
+
+  for (i = 0; i < display_width * display_height; i++, buffer += tc_bpp)
+    truecolour_putcol(buffer, bg_colour);
+}
+
+
+/* *********************************
+   truecolour_stage(image, sx, sy, w, h)
+   *********************************
+   copies an area of the scaled frame into the staging buffer if the screen area doesn't fit into
+   the display (else sws has already scaled into the staging buffer).
+   rgb565 with dithering: the tone curve is applied to the rgb24 frame, which is ordered dithered into the staging buffer
+   *********************************
+   image  ... scaled frame (screen area, stride: image_stride[0])
+   sx/sy  ... phys. start position
+   w/h    ... width/height of area
+   *********************************
+   --
+*/
+static void truecolour_stage(const unsigned char* image, int sx, int sy, int w, int h) {
+  int x, y;
+
+  if (!tc_scaled)
+    return;
+
+  if (tc_dither) {
+    for (y = sy; y < sy + h; y++) {
+      const unsigned char* src = image + (y - screen_y) * image_stride[0] + (sx - screen_x) * 3;
+      const unsigned char* thr = tc_ditherthr[y & 3];
+      uint16_t* dst = (uint16_t*)(tc_stage + (y * display_width + sx) * 2);
+
+      for (x = 0; x < w; x++, src += 3) {
+        int t = thr[(sx + x) & 3];
+        int r = tone_lut[src[0]] + (t >> 1), g = tone_lut[src[1]] + (t >> 2), b = tone_lut[src[2]] + (t >> 1);
+
+        dst[x] = (((r > MAX_GREYVALUE) ? 0x1F : r >> 3) << 11) | (((g > MAX_GREYVALUE) ? 0x3F : g >> 2) << 5) |
+                  ((b > MAX_GREYVALUE) ? 0x1F : b >> 3);
+      }
+    }
+    return;
+  }
+
+  for (y = sy; y < sy + h; y++)
+    memcpy(tc_stage + (y * display_width + sx) * tc_bpp, image + (y - screen_y) * image_stride[0] + (sx - screen_x) * tc_bpp, w * tc_bpp);
+}
+
+
+/* *********************************
+   drawingalgo_truecolour(image, sx, sy, w, h)
+   *********************************
+   draws a frame directly on a colour display (without dithering, ...)
+   *********************************
+   image  ... mplayer frame
+   sx/sy  ... phys. start position
+   w/h    ... width/height of frame
+   *********************************
+   --
+*/
+static void drawingalgo_truecolour(unsigned char** image, int sx, int sy, int w, int h) {
+  truecolour_stage(image[0], sx, sy, w, h);
+  truecolour_tone(tc_stage, sx, sy, w, h);
+  truecolour_output(tc_stage, sx, sy, w, h);
+}
+
+
+/* *********************************
+   drawingalgo_deferred(image, sx, sy, w, h)
+   *********************************
+   asynchronous output of a truecolour display: only the tone curve is applied here,
+   the frame is output by the display I/O thread
+   *********************************
+   --
+*/
+static void drawingalgo_deferred(unsigned char** image, int sx, int sy, int w, int h) {
+  truecolour_stage(image[0], sx, sy, w, h);
+  truecolour_tone(tc_stage, sx, sy, w, h);
+}
+
+
+
+/* *********************************
+   stage_add(stage, start)
+   *********************************
+   adds the time elapsed since 'start' to the duration of a stage in the current frame
+   *********************************
+   stage  ... stage (STAGE_*)
+   start  ... GetTimer() at the beginning of the stage
+   *********************************
+   --
+*/
+static inline void stage_add(int stage, unsigned int start) {
+  stage_frameus[stage] += GetTimer() - start;
+  stage_framehit[stage] = 1;
+}
+
+
+/* *********************************
+   stage_bucket(us)
+   *********************************
+   histogram bucket of a duration: exact below 8 usec, above 8 buckets per power of two
+   *********************************
+   us     ... duration (usec)
+   *********************************
+   returns the bucket index
+   *********************************
+   --
+*/
+static int stage_bucket(unsigned int us) {
+  int e = 3, b;
+
+  if (us < 8)
+    return us;
+  while ((us >> e) > 1)
+    e++;
+  b = 8 * (e - 2) + ((us >> (e - 3)) & 7);
+  return (b < SD_STAGE_BUCKETS) ? b : SD_STAGE_BUCKETS - 1;
+}
+
+
+/* *********************************
+   stage_commit(first, last)
+   *********************************
+   records the durations of the stages 'first' .. 'last' of the current frame and resets them
+   *********************************
+   first  ... first stage
+   last   ... last stage
+   *********************************
+   --
+*/
+static void stage_commit(int first, int last) {
+  int s;
+
+#if HAVE_PTHREADS
+  if (async_started)
+    pthread_mutex_lock(&async_mutex);
+#endif
+  for (s = first; s <= last; s++) {
+    stage_stat_t* st = &stage_stats[s];
+    unsigned int us = stage_frameus[s];
+
+    if (!stage_framehit[s])
+      continue;
+    if (!st->n || us < st->min)
+      st->min = us;
+    if (us > st->max)
+      st->max = us;
+    st->sum += us;
+    st->hist[stage_bucket(us)]++;
+    st->n++;
+    stage_frameus[s] = 0;
+    stage_framehit[s] = 0;
+  }
+#if HAVE_PTHREADS
+  if (async_started)
+    pthread_mutex_unlock(&async_mutex);
+#endif
+}
+
+
+/* *********************************
+   stage_percentile(st, pct)
+   *********************************
+   approximates a percentile of the durations recorded for a stage using the histogram
+   (upper bound of the bucket, limited by the max. duration)
+   *********************************
+   st     ... stage statistics
+   pct    ... percentile [0, 100]
+   *********************************
+   returns the duration (usec)
+   *********************************
+   --
+*/
+static unsigned int stage_percentile(const stage_stat_t* st, int pct) {
+  unsigned long need = (st->n * pct + 99) / 100, cnt = 0;
+  unsigned int upper = st->max;
+  int b;
+
+  for (b = 0; b < SD_STAGE_BUCKETS - 1; b++) {
+    cnt += st->hist[b];
+    if (cnt >= need && cnt) {
+      if (b < 8) {
+        upper = b;
+      } else {
+        int e = b / 8 + 2;
+        upper = ((9 + (b & 7)) << (e - 3)) - 1;
+      }
+      break;
+    }
+  }
+  return (upper < st->max) ? upper : st->max;
+}
+
+
+/* *********************************
+   stats_snapshot(stats, counts)
+   *********************************
+   copies the stage statistics and the frame counters (frames output, frames dropped, pixels changed, bytes pushed,
+   max. pixels changed in one frame)
+   *********************************
+   stats  ... destination for SD_STAGES stage statistics
+   counts ... destination for 5 counters
+   *********************************
+   --
+*/
+static void stats_snapshot(stage_stat_t* stats, unsigned long long* counts) {
+#if HAVE_PTHREADS
+  if (async_started)
+    pthread_mutex_lock(&async_mutex);
+#endif
+  memcpy(stats, stage_stats, sizeof(stage_stats));
+  counts[0] = stat_frames;
+  counts[1] = stat_framesskipped + stat_asyncdropped;
+  counts[2] = stat_changedpixels;
+  counts[3] = stat_bytes;
+  counts[4] = stat_maxchangedpixels;
+#if HAVE_PTHREADS
+  if (async_started)
+    pthread_mutex_unlock(&async_mutex);
+#endif
+}
+
+
+/* *********************************
+   stats_writecsv()
+   *********************************
+   writes a line with the accumulated statistics to the statistics file (option 'statsfile').
+   columns: frames, dropped, pixels, bytes, max. pixels per frame, per stage: calls, min, avg, p95, max (usec)
+   *********************************
+   --
+*/
+static void stats_writecsv(void) {
+  stage_stat_t stats[SD_STAGES];
+  unsigned long long counts[5];
+  int s;
+
+  stats_snapshot(stats, counts);
+  fprintf(stats_file, "%llu,%llu,%llu,%llu,%llu", counts[0], counts[1], counts[2], counts[3], counts[4]);
+  for (s = 0; s < SD_STAGES; s++) {
+    fprintf(stats_file, ",%lu,%u,%.1f,%u,%u", stats[s].n, stats[s].min,
+                        (stats[s].n) ? (double)stats[s].sum / stats[s].n : 0.0,
+                        stage_percentile(&stats[s], 95), stats[s].max);
+  }
+  fprintf(stats_file, "\n");
+  fflush(stats_file);
+}
+
+
+/* *********************************
+   stats_print(level)
+   *********************************
+   prints the per-stage timing and the frame counters
+   *********************************
+   level  ... message level
+   *********************************
+   --
+*/
+static void stats_print(int level) {
+  stage_stat_t stats[SD_STAGES];
+  unsigned long long counts[5];
+  int s;
+
+  stats_snapshot(stats, counts);
+  mp_msg(MSGT_VO, level, "vo_serdisp: frames drawn: %llu, dropped: %llu, pixels changed: %llu (avg. %.1f, max. %llu per frame), "
+                         "bytes pushed: %llu\n", counts[0], counts[1], counts[2], 
+                         (counts[0]) ? (double)counts[2] / counts[0] : 0.0, counts[4], counts[3]);
+  mp_msg(MSGT_VO, level, "vo_serdisp: %-12s %8s %8s %8s %8s %8s  (usec per frame)\n",
+                         "stage", "frames", "min", "avg", "p95", "max");
+  for (s = 0; s < SD_STAGES; s++) {
+    if (!stats[s].n)
+      continue;
+    mp_msg(MSGT_VO, level, "vo_serdisp: %-12s %8lu %8u %8.1f %8u %8u\n", stats[s].name, stats[s].n, stats[s].min,
+                           (double)stats[s].sum / stats[s].n, stage_percentile(&stats[s], 95), stats[s].max);
+  }
+}
+
+
+/* *********************************
+   osd_cleanup(buf)
+   *********************************
+   restores the rows the OSD overlay has been blitted over with the last frame.
+   the drawing routines might not use the whole display area for drawing a frame (because of aspect ratio a.s.o.), 
+   but the OSD always uses the bottom of the display. the parts not reached by the drawing routine are output
+   from the frame (borders contain the background colour)
+   *********************************
+   buf    ... frame that has been output (greyscale/monochrome: packed frame buffer, truecolour: staging buffer)
+   *********************************
+   --
+*/
+static void osd_cleanup(unsigned char* buf) {
+  void (*output) (unsigned char* buf, int sx, int sy, int w, int h) = (sdbuf) ? sdbuf_output : truecolour_output;
+  unsigned int start;
+  int y, run_y = -1;
+  int bx0 = (screen_x > 0) ? screen_x : 0;                  /* columns reached by the drawing routine */
+  int bx1 = (screen_x + screen_w < display_width) ? screen_x + screen_w : display_width;
+
+  if (osd_blity1 <= osd_blity0)
+    return;
+  start = GetTimer();
+
+  for (y = osd_blity0; y <= osd_blity1; y++) {
+    int reached = 1;
+
+    if (y < osd_blity1) {
+      if (sdbuf) {
+        /* rows still invalid haven't been output by the drawing routine */
+        reached = !sdbuf_rowinvalid[y];
+        sdbuf_rowinvalid[y] = 0;
+      } else {
+        reached = (y >= screen_y && y < screen_y + screen_h);
+      }
+      if (!reached) {
+        if (run_y < 0)
+          run_y = y;
+        continue;
+      }
+    }
+    if (run_y >= 0) {
+      output(buf, 0, run_y, display_width, y - run_y);
+      run_y = -1;
+    }
+    if (y < osd_blity1 && (sdbuf || !isclipareasave)) {
+      /* row only output between bx0 and bx1 (truecolour serdisp_cliparea() outputs full rows) */
+      if (bx0 > 0)
+        output(buf, 0, y, bx0, 1);
+      if (bx1 < display_width)
+        output(buf, bx1, y, display_width - bx1, 1);
+    }
+  }
+
+  sd_dirty = 1;
+  osd_blity0 = osd_blity1 = 0;  /* do this only once */
+  stage_add(STAGE_OSDCLEANUP, start);
+}
+
+
+/* *********************************
+   osd_drawalpha(x0, y0, w, h, src, srca, stride)
+   *********************************
+   callback for vo_draw_text(): renders OSD text into the OSD layer.
+   the text is not blended with the video (the layer is cached independent of it): pixels with
+   alpha != 0 are covered using the text grey value
+   *********************************
+   x0/y0  ... position
+   w/h    ... dimension
+   src    ... grey values
+   srca   ... alpha values (0: transparent)
+   stride ... bytes per row of src and srca
+   *********************************
+   --
+*/
+static void osd_drawalpha(int x0, int y0, int w, int h, unsigned char* src, unsigned char* srca, int stride) {
+  int x, y;
+
+  for (y = 0; y < h; y++) {
+    unsigned char* l;
+    unsigned char* a;
+
+    if (y0 + y < 0 || y0 + y >= view_height)
+      continue;
+    l = osd_layer + (y0 + y) * view_width;
+    a = osd_layeralpha + (y0 + y) * view_width;
+    for (x = 0; x < w; x++) {
+      if (x0 + x >= 0 && x0 + x < view_width && srca[y * stride + x]) {
+        l[x0 + x] = src[y * stride + x];
+        a[x0 + x] = 1;
+      }
+    }
+    if (y0 + y < osd_layery0) osd_layery0 = y0 + y;
+    if (y0 + y >= osd_layery1) osd_layery1 = y0 + y + 1;
+  }
+}
+
+
+/* *********************************
+   osd_build(type, value)
+   *********************************
+   rebuilds the OSD layer (as seen by the viewer): progress bar and OSD text
+   *********************************
+   type   ... progress bar type (-1: no progress bar)
+   value  ... progress bar value [0, 255]
+   *********************************
+   --
+*/
+static void osd_build(int type, int value) {
+  int i, j, s, savedtype;
+  int bordergap = SD_OSD_BORDERGAP;
+  unsigned char fg = (fg_colour == SD_COL_WHITE) ? MAX_GREYVALUE : 0;
+
+  if (osd_layery1 > osd_layery0)
+    memset(osd_layeralpha + osd_layery0 * view_width, 0, (osd_layery1 - osd_layery0) * view_width);
+  osd_layery0 = view_height;
+  osd_layery1 = 0;
+
+  if (type != -1) {
+    int bar_width = ((view_width - 2 * bordergap) * value) / 255;
+
+    if (bar_width > view_width - 2 * bordergap) bar_width = view_width - 2 * bordergap;
+    if (bar_width < 0) bar_width = 0;
+
+    /* draw background using foreground colour */
+    memset(osd_layer + osd_posy * view_width, fg, osd_height * view_width);
+    memset(osd_layeralpha + osd_posy * view_width, 1, osd_height * view_width);
+    /* draw progress-bar using background colour */
+    for (j = osd_posy + osd_margin ; j < osd_posy + osd_margin + osd_bar_height ; j++) {
+      unsigned char* l = osd_layer + j * view_width;
+
+      memset(l + bordergap, fg ^ 0xFF, bar_width);
+      for (s = 0; s < 5; s++) {
+        i = bordergap +   (((view_width - bordergap*2) / 4) * s);
+        if (!(s % 2) || (j % 2)) {
+          l[i] ^= 0xFF;
+        }
+      }
+    }
+    osd_layery0 = osd_posy;
+    osd_layery1 = osd_posy + osd_height;
+  }
+
+  /* OSD text. the progress bar is drawn by the vo itself (also without a font), so it's hidden from vo_draw_text() */
+  savedtype = vo_osd_progbar_type;
+  vo_osd_progbar_type = -1;
+  vo_draw_text(view_width, view_height, osd_drawalpha);
+  vo_osd_progbar_type = savedtype;
+
+  osd_progbar_type = type;
+  osd_progbar_value = value;
+  osd_layergen++;
+}
+
+
+/* *********************************
+   osd_convert()
+   *********************************
+   converts the rows covered by the OSD layer into display format (pre-rotation: and display orientation)
+   *********************************
+   --
+*/
+static void osd_convert(void) {
+  int x, y, y0 = osd_layery0, y1 = osd_layery1;
+
+  if (rot_mode == 180) {
+    y0 = display_height - osd_layery1;
+    y1 = display_height - osd_layery0;
+  } else if (rot_mode && y1 > y0) {
+    /* layer rows become display columns */
+    y0 = 0;
+    y1 = display_height;
+  }
+
+  for (y = y0; y < y1; y++) {
+    const unsigned char* l = osd_layer + y * display_width;
+    const unsigned char* a = osd_layeralpha + y * display_width;
+    unsigned char* o = osd_ovl + y * osd_ovlstride;
+    unsigned char* m = osd_ovlmask + y * osd_maskstride;
+
+    if (rot_mode) {
+      for (x = 0; x < display_width; x++) {
+        int i;
+
+        switch (rot_mode) {
+          case 90:  i = (display_width - 1 - x) * view_width + y; break;
+          case 180: i = (display_height - 1 - y) * view_width + display_width - 1 - x; break;
+          default:  i = x * view_width + display_height - 1 - y;
+        }
+        osd_rotrow[x] = osd_layer[i];
+        osd_rotrow[display_width + x] = osd_layeralpha[i];
+      }
+      l = osd_rotrow;
+      a = osd_rotrow + display_width;
+    }
+
+    if (istruecolour) {
+      for (x = 0; x < display_width; x++) {
+        truecolour_putcol(o + x * tc_bpp, 0xFF000000 | (l[x] << 16) | (l[x] << 8) | l[x]);
+        m[x] = a[x];
+      }
+    } else {
+      memset(o, 0, osd_ovlstride);
+      memset(m, 0, osd_maskstride);
+      for (x = 0; x < display_width; x++) {
+        if (a[x]) {
+          int shift = ((~x) & sdbuf_xmask) << sdbuf_dshift;
+
+          o[x >> sdbuf_xshift] |= grey2idx[l[x]] << shift;
+          m[x >> sdbuf_xshift] |= sdbuf_idxmask << shift;
+        }
+      }
+    }
+  }
+  osd_ovly0 = y0;
+  osd_ovly1 = y1;
+  osd_ovlgen = osd_layergen;
+}
+
+
+/* *********************************
+   osd_blit(buf)
+   *********************************
+   composites the OSD overlay with the frame that has been output and outputs the rows covered
+   (one serdisp_cliparea() call if possible, else the pixels covered only)
+   *********************************
+   buf    ... frame that has been output (greyscale/monochrome: packed frame buffer, truecolour: staging buffer)
+   *********************************
+   --
+*/
+static void osd_blit(const unsigned char* buf) {
+  unsigned int start = GetTimer();
+  int x, y, n;
+
+#if HAVE_PTHREADS
+  if (async_started)
+    pthread_mutex_lock(&async_mutex);
+#endif
+  if (osd_ovlgen != osd_layergen)
+    osd_convert();
+#if HAVE_PTHREADS
+  if (async_started)
+    pthread_mutex_unlock(&async_mutex);
+#endif
+
+  if (osd_ovly1 <= osd_ovly0)
+    return;
+  n = osd_ovly1 - osd_ovly0;
+
+  if (!istruecolour) {
+    for (y = osd_ovly0; y < osd_ovly1; y++) {
+      const unsigned char* f = buf + y * sdbuf_stride;
+      const unsigned char* o = osd_ovl + y * osd_ovlstride;
+      const unsigned char* m = osd_ovlmask + y * osd_maskstride;
+      unsigned char* c = osd_comp + (y - osd_ovly0) * osd_ovlstride;
+
+      for (x = 0; x < sdbuf_stride; x++)
+        c[x] = (f[x] & ~m[x]) | o[x];
+      if (!isclipareasave) {
+        for (x = 0; x < display_width; x++) {
+          int shift = ((~x) & sdbuf_xmask) << sdbuf_dshift;
+
+          if ((m[x >> sdbuf_xshift] >> shift) & sdbuf_idxmask)
+            sd_setsdgrey(&sd_out, x, y, idx2grey[(o[x >> sdbuf_xshift] >> shift) & sdbuf_idxmask]);
+        }
+      }
+    }
+    if (isclipareasave) {
+      sd_cliparea(&sd_out, 0, osd_ovly0, display_width, n, 0, 0, display_width, n, sdbuf_depth, osd_comp);
+      frame_bytes += sdbuf_stride * n;
+    } else {
+      frame_bytes += (n * display_width * display_depth + 7) >> 3;
+    }
+    sdbuf_invalidate(osd_ovly0, n);  /* osd rows need to be redrawn with the next frame */
+  } else if (isclipareasave) {
+    for (y = osd_ovly0; y < osd_ovly1; y++) {
+      const unsigned char* o = osd_ovl + y * osd_ovlstride;
+      const unsigned char* m = osd_ovlmask + y * osd_maskstride;
+      const unsigned char* f = buf + y * osd_ovlstride;
+      unsigned char* c = osd_comp + (y - osd_ovly0) * osd_ovlstride;
+
+      for (x = 0; x < osd_ovlstride; x++)
+        c[x] = (m[x / tc_bpp]) ? o[x] : f[x];
+    }
+    sd_cliparea(&sd_out, 0, osd_ovly0, display_width, n, 0, 0, display_width, n, tc_bpp * 8, osd_comp);
+    frame_bytes += (n * display_width * display_depth + 7) >> 3;
+  } else {
+    for (y = osd_ovly0; y < osd_ovly1; y++) {
+      const unsigned char* o = osd_ovl + y * osd_ovlstride;
+      const unsigned char* m = osd_ovlmask + y * osd_maskstride;
+
+      for (x = 0; x < display_width; x++) {
+        if (m[x])
+          sd_setsdcol(&sd_out, x, y, truecolour_getcol(o + x * tc_bpp));
+      }
+    }
+    frame_bytes += (n * display_width * display_depth + 7) >> 3;
+  }
+
+  osd_blity0 = osd_ovly0;  /* clean up remainders of osd with the next frame */
+  osd_blity1 = osd_ovly1;
+  sd_dirty = 1;
+  stage_add(STAGE_OSD, start);
+}
+
+
+/* *********************************
+   output_update()
+   *********************************
+   updates the display (greyscale/monochrome: only if something has changed) and
+   accumulates statistics of the frame
+   *********************************
+   --
+*/
+static void output_update(void) {
+  unsigned int now;
+
+  if (istruecolour || sd_dirty) {
+    unsigned int start = GetTimer();
+    int dur;
+
+    sd_update(&sd_out, frame_bytes);
+    dur = (int)(GetTimer() - start);
+    stage_add(STAGE_UPDATE, start);
+    /* moving average of display link time (read by frame_checkskip()) */
+#if HAVE_PTHREADS
+    if (async_started)
+      pthread_mutex_lock(&async_mutex);
+#endif
+    link_avgus = (stat_frames) ? (link_avgus * 7 + dur) >> 3 : dur;
+    if (frame_bytes && dur > 0)
+      link_rate = (link_rate > 0.0) ? (link_rate * 7 + (double)frame_bytes / dur) / 8 : (double)frame_bytes / dur;
+#if HAVE_PTHREADS
+    if (async_started)
+      pthread_mutex_unlock(&async_mutex);
+#endif
+  } else {
+    stat_skippedupdates++;
+  }
+  sd_dirty = 0;
+
+  if (serdisp_flag_debug && !istruecolour) {
+    mp_msg(MSGT_VO, MSGL_DBG2, "vo_serdisp: frame %lu: changed pixels: %lu / %lu (%.1f%%)\n", stat_frames,
+                               frame_changedpixels, frame_drawnpixels, 
+                               (frame_drawnpixels) ? (100.0 * frame_changedpixels / frame_drawnpixels) : 0.0);
+  }
+  now = GetTimer();
+  if (stat_frames)
+    stat_outputus += now - stat_lastoutput;
+  stat_lastoutput = now;
+
+  stat_frames++;
+  stat_drawnpixels += frame_drawnpixels;
+  stat_changedpixels += frame_changedpixels;
+  if (frame_changedpixels > stat_maxchangedpixels)
+    stat_maxchangedpixels = frame_changedpixels;
+  stat_bytes += frame_bytes;
+  frame_drawnpixels = 0;
+  frame_changedpixels = 0;
+  frame_bytes = 0;
+  stage_commit(STAGE_OSD, STAGE_UPDATE);
+
+  if (stats_file && !(stat_frames % serdisp_flag_statsinterval))
+    stats_writecsv();
+}
+
+
+#if HAVE_PTHREADS
+/* *********************************
+   async_outputthread(arg)
+   *********************************
+   display I/O thread: takes frames from the mailbox and outputs them
+   (frame content, OSD overlay, display update)
+   *********************************
+   --
+*/
+static void* async_outputthread(void* arg) {
+  unsigned char* tmp;
+  unsigned int start;
+
+  pthread_mutex_lock(&async_mutex);
+  for (;;) {
+    while (!async_pending && !async_quit)
+      pthread_cond_wait(&async_cond, &async_mutex);
+    if (!async_pending)   /* termination requested and no frame left */
+      break;
+
+    tmp = async_frontbuf;
+    async_frontbuf = async_pendingbuf;
+    async_pendingbuf = tmp;
+    async_pending = 0;
+    async_busy = 1;
+    pthread_mutex_unlock(&async_mutex);
+
+    start = GetTimer();
+    if (istruecolour) {
+      int sx = screen_x, sy = screen_y, w = screen_w, h = screen_h;
+
+      if (drawing_clip(&sx, &sy, &w, &h))
+        truecolour_output(async_frontbuf, sx, sy, w, h);
+    } else if (serdisp_flag_progressive) {
+      prog_flush(async_frontbuf);
+    } else {
+      sdbuf_flush(async_frontbuf, 0, 0, display_width, display_height);
+    }
+    stage_add(STAGE_UPDATE, start);   /* frame content output is part of the update stage */
+    osd_cleanup(async_frontbuf);
+    osd_blit(async_frontbuf);
+    output_update();
+
+    pthread_mutex_lock(&async_mutex);
+    async_busy = 0;
+    pthread_cond_broadcast(&async_cond);
+  }
+  pthread_mutex_unlock(&async_mutex);
+  return NULL;
+}
+
+
+/* *********************************
+   async_handover()
+   *********************************
+   hands the frame drawn over to the display I/O thread (the drawing buffer is swapped with the mailbox)
+   *********************************
+   --
+*/
+static void async_handover(void) {
+  unsigned char** backbuf = (istruecolour) ? &tc_stage : &sdbuf;
+  unsigned char* tmp;
+
+  pthread_mutex_lock(&async_mutex);
+  if (async_pending)
+    stat_asyncdropped++;
+
+  tmp = *backbuf;
+  *backbuf = async_pendingbuf;
+  async_pendingbuf = tmp;
+  async_pending = 1;
+
+  pthread_cond_broadcast(&async_cond);
+  pthread_mutex_unlock(&async_mutex);
+
+  if (istruecolour && !tc_scaled) {
+    image[0] = tc_stage + tc_offset;   /* sws scales (or pre-rotation rotates) directly into the staging buffer */
+    if (!rot_mode)
+      image_scaled[0] = image[0];
+  }
+}
+
+
+/* *********************************
+   async_wait()
+   *********************************
+   waits until the display I/O thread has output all frames handed over
+   *********************************
+   --
+*/
+static void async_wait(void) {
+  pthread_mutex_lock(&async_mutex);
+  while (async_pending || async_busy)
+    pthread_cond_wait(&async_cond, &async_mutex);
+  pthread_mutex_unlock(&async_mutex);
+}
+#endif
+
+
+/* *********************************
+   frame_checkskip()
+   *********************************
+   decides whether the next frame is drawn or skipped, before any scaling or drawing is done.
+   the min. distance between two frames drawn is derived from 'maxfps' and (if 'framedrop' is set)
+   from the time the display link needs for one update (sustainable frame rate).
+   the distance is measured in wall clock time (GetTimer(), wrap-around safe)
+   *********************************
+   returns 1 if the frame is to be skipped, else 0
+   *********************************
+   --
+*/
+static int frame_checkskip(void) {
+  unsigned int now = GetTimer();
+  unsigned int elapsed = now - frame_lasttime;
+  unsigned int interval = (serdisp_flag_maxfps > 0) ? 1000000 / serdisp_flag_maxfps : 0;
+
+  if (sd_cache.data)   /* replaying the playback cache: frames are output by flip_page() */
+    return 1;
+
+  if (serdisp_flag_framedrop) {
+    int linkus;
+
+#if HAVE_PTHREADS
+    if (async_started) {
+      pthread_mutex_lock(&async_mutex);
+      linkus = link_avgus;
+      pthread_mutex_unlock(&async_mutex);
+    } else
+#endif
+      linkus = link_avgus;
+
+    if (linkus > 0 && (unsigned int)linkus > interval)
+      interval = linkus;
+  }
+
+  if (frame_started && elapsed < interval)
+    return 1;
+
+  /* moving average of the frame period (read by prog_budget()), gaps of more than a second are ignored */
+  if (frame_started && elapsed < 1000000) {
+    int period = (int)elapsed;
+
+#if HAVE_PTHREADS
+    if (async_started)
+      pthread_mutex_lock(&async_mutex);
+#endif
+    frame_periodus = (frame_periodus) ? (frame_periodus * 7 + period) >> 3 : period;
+#if HAVE_PTHREADS
+    if (async_started)
+      pthread_mutex_unlock(&async_mutex);
+#endif
+  }
+  frame_lasttime = now;
+  frame_started = 1;
+  return 0;
+}
+
+
+/* *********************************
+   band_free() / band_init()
+   *********************************
+   frees the sws contexts of the bands /
+   splits the scaled frame into one horizontal band per drawing thread and creates an sws context for every band.
+   source bands start at even rows (chroma planes of yuv 4:2:0), the edges of the bands are filtered independently
+   *********************************
+   --
+*/
+static void band_free(void) {
+  int b;
+
+  for (b = 0; b < band_count; b++)
+    sws_freeContext(band_sws[b]);
+  band_count = 0;
+}
+
+static void band_init(void) {
+  int b;
+
+  band_free();
+#if HAVE_PTHREADS
+  if (pool_size < 2 || fused_enabled || image_height < 8 * pool_size || src_height < 8 * pool_size)
+    return;
+
+  for (b = 0; b <= pool_size; b++) {
+    band_srcy[b] = (b < pool_size) ? ((b * src_height) / pool_size) & ~1 : src_height;
+    band_y[b] = (b < pool_size) ? (band_srcy[b] * image_height + (src_height >> 1)) / src_height : image_height;
+  }
+  for (b = 0; b < pool_size; b++) {
+    band_sws[b] = sws_getContextFromCmdLine(src_width, band_srcy[b+1] - band_srcy[b], (image_lumaonly) ? IMGFMT_Y8 : image_format,
+                                            image_width, band_y[b+1] - band_y[b], 
+                                            (istruecolour) ? ((tc_bpp == 2 && !tc_dither) ? IMGFMT_BGR16 : IMGFMT_RGB24) : IMGFMT_Y8);
+    if (!band_sws[b])
+      break;
+    band_count++;
+  }
+  if (band_count < pool_size) {
+    mp_msg(MSGT_VO,MSGL_WARN,"vo_serdisp: unable to create sws contexts for banded scaling, using one thread\n");
+    band_free();
+  }
+#endif
+}
+
+
+#if HAVE_PTHREADS
+/* *********************************
+   band_scale(t, n) / band_draw(t, n)
+   *********************************
+   jobs for the drawing threads: scale the bands of band_job.src /
+   (pre-rotation: rotate and) draw rows of band_job's area into the packed frame buffer or the staging buffer
+   without output (only drawing routines which draw rows independently)
+   *********************************
+   t      ... thread number
+   n      ... number of threads
+   *********************************
+   --
+*/
+static void band_scale(int t, int n) {
+  int b, p;
+
+  for (b = t; b < band_count; b += n) {
+    const uint8_t* src[3];
+    uint8_t* dst[3] = { image_scaled[0] + band_y[b] * image_scaledstride[0], NULL, NULL };
+
+    src[0] = band_job.src[0] + band_srcy[b] * band_job.stride[0];
+    for (p = 1; p < 3; p++)   /* chroma planes: vertically subsampled */
+      src[p] = (band_job.src[p]) ? band_job.src[p] + (band_srcy[b] >> 1) * band_job.stride[p] : NULL;
+    sws_scale(band_sws[b], src, band_job.stride, 0, band_srcy[b+1] - band_srcy[b], dst, image_scaledstride);
   }
 }
 
+static void band_draw(int t, int n) {
+  int y0 = band_job.sy + (band_job.h * t) / n;
+  int h = band_job.sy + (band_job.h * (t + 1)) / n - y0;
+
+  if (h <= 0)
+    return;
+  if (rot_mode)
+    rot_frame(image_scaled[0], image_scaledstride[0], band_job.sx, y0, band_job.w, h);
+
+  if (istruecolour)
+    drawingalgo_deferred(image, band_job.sx, y0, band_job.w, h);
+  else if (serdisp_flag_algo == 2)
+    ordered_rows(image, band_job.sx, y0, band_job.w, h, ordered_line + t * (display_width + 16));
+  else
+    directgrey_rows(image, band_job.sx, y0, band_job.w, h);
+}
+#endif
+
+
+/* *********************************
+   band_frame(src, stride)
+   *********************************
+   scales and draws a complete frame in bands using all drawing threads, output is done once all bands are finished.
+   error diffusion dithering draws the frame as a whole (threads are used for the wavefront)
+   *********************************
+   src    ... source planes
+   stride ... strides of source planes
+   *********************************
+   --
+*/
+static void band_frame(uint8_t* src[], int stride[]) {
+#if HAVE_PTHREADS
+  int p, sx = screen_x, sy = screen_y, w = screen_w, h = screen_h;
+  unsigned int start = GetTimer();
+
+  for (p = 0; p < 3; p++) {
+    band_job.src[p] = (p == 0 || !image_lumaonly) ? src[p] : NULL;
+    band_job.stride[p] = stride[p];
+  }
+  pool_run(band_scale);
+  stage_add(STAGE_SWS, start);
+
+  start = GetTimer();
+  if (istruecolour || serdisp_flag_algo == 0 || serdisp_flag_algo == 2) {
+    if (drawing_clip(&sx, &sy, &w, &h)) {
+      band_job.sx = sx;
+      band_job.sy = sy;
+      band_job.w = w;
+      band_job.h = h;
+      pool_run(band_draw);
+      if (!serdisp_flag_async) {
+        if (sdbuf)
+          sdbuf_flush(sdbuf, sx, sy, w, h);
+        else
+          truecolour_output(tc_stage, sx, sy, w, h);
+      }
+    }
+  } else if (rot_mode) {
+    drawing_rotated(image_scaled[0], image_scaledstride[0]);
+  } else if (drawing_clip(&sx, &sy, &w, &h)) {
+    drawing_algo(image, sx, sy, w, h);
+  }
+  stage_add(STAGE_DRAWING, start);
+#endif
+}
+
+
+/* *********************************
+   image_free()
+   *********************************
+   frees the buffers for scaled frames
+   *********************************
+   --
+*/
+static void image_free(void) {
+  if (image_buf) {
+    free(image_buf);
+    image_buf = NULL;
+  }
+  if (tc_scaled) {
+    free(tc_scaled);
+    tc_scaled = NULL;
+  }
+  if (rot_scaled) {
+    free(rot_scaled);
+    rot_scaled = NULL;
+  }
+  image[0] = NULL;
+  image_scaled[0] = NULL;
+}
+
+
+/* *********************************
+   image_alloc()
+   *********************************
+   (re-)allocates the buffer sws scales into using the current geometry.
+   truecolour: sws scales directly into the staging buffer if the screen area fits into the display,
+   else (viewmode 1 or 2, rgb565 with dithering) into a separate buffer.
+   pre-rotation: sws scales into rot_scaled, which is rotated into these buffers
+   *********************************
+   returns 0 if ok, else -1
+   *********************************
+   --
+*/
+static int image_alloc(void) {
+  image_free();
+
+  if (istruecolour) {
+    if (!tc_dither && screen_x >= 0 && screen_y >= 0 && screen_w <= display_width && screen_h <= display_height) {
+      tc_offset = (screen_y * display_width + screen_x) * tc_bpp;
+      image[0] = tc_stage + tc_offset;
+      image_stride[0] = display_width * tc_bpp;
+    } else {
+      tc_scaled = (unsigned char*)malloc(image_stride[0] * screen_h);
+      image[0] = tc_scaled;
+    }
+  } else {
+    image_buf = (unsigned char*)malloc(image_stride[0] * screen_h);
+    image[0] = image_buf;
+  }
+
+  if (rot_mode) {
+    image_scaledstride[0] = (image_width * image_bpp + 31) & ~31;
+    rot_scaled = (unsigned char*)malloc(image_scaledstride[0] * image_height);
+    image_scaled[0] = rot_scaled;
+  } else {
+    image_scaledstride[0] = image_stride[0];
+    image_scaled[0] = image[0];
+  }
+  return (image[0] && image_scaled[0]) ? 0 : -1;
+}
+
+
+/* *********************************
+   dr_free() / dr_init()
+   *********************************
+   frees the direct rendering buffers /
+   allocates them if the frame doesn't need to be scaled (luma plane of yuv input on greyscale/monochrome displays)
+   *********************************
+   --
+*/
+static void dr_free(void) {
+  int b;
+
+  for (b = 0; b < SD_DR_BUFFERS; b++) {
+    if (dr_buf[b]) {
+      free(dr_buf[b]);
+      dr_buf[b] = NULL;
+    }
+  }
+  dr_possible = 0;
+}
+
+static void dr_init(void) {
+  int b;
+
+  dr_free();
+  if (!image_lumaonly || src_width != image_width || src_height != image_height)
+    return;
+
+  /* decoders may request heights aligned to the macroblock size */
+  dr_height = (src_height + 31) & ~31;
+  for (b = 0; b < SD_DR_BUFFERS; b++) {
+    /* chroma planes (ignored): YV12/I420: 2 * stride/2 * height/2, NV12: stride * height/2 */
+    dr_buf[b] = (unsigned char*)malloc(image_scaledstride[0] * dr_height + image_scaledstride[0] * (dr_height >> 1));
+    if (!dr_buf[b]) {
+      mp_msg(MSGT_VO,MSGL_WARN,"vo_serdisp: unable to allocate buffers for direct rendering\n");
+      dr_free();
+      return;
+    }
+  }
+  dr_possible = 1;
+}
+
+
+/* *********************************
+   get_image(mpi)
+   *********************************
+   direct rendering: passes one of our buffers to the decoder.
+   reference frames (I/P) alternate between buffers 0 and 1, all other frames use buffer 2
+   *********************************
+   mpi    ... image requested by the decoder
+   *********************************
+   returns VO_TRUE if a buffer was passed, else VO_FALSE
+   *********************************
+   --
+*/
+static int get_image(mp_image_t* mpi) {
+  int b;
+  unsigned char* buf;
+
+  if (!dr_possible || mpi->imgfmt != image_format ||
+      mpi->type == MP_IMGTYPE_EXPORT || mpi->type == MP_IMGTYPE_NUMBERED ||
+      (mpi->flags & MP_IMGFLAG_DRAW_CALLBACK) ||   /* slices are scaled and drawn by draw_slice() */
+      mpi->width > image_scaledstride[0] || mpi->height > dr_height ||
+      (!(mpi->flags & (MP_IMGFLAG_ACCEPT_STRIDE | MP_IMGFLAG_ACCEPT_WIDTH)) && mpi->width != image_scaledstride[0]))
+    return VO_FALSE;
+
+  if ((mpi->type == MP_IMGTYPE_IP || mpi->type == MP_IMGTYPE_IPB) && (mpi->flags & MP_IMGFLAG_READABLE)) {
+    dr_ipbuf ^= 1;
+    b = dr_ipbuf;
+  } else {
+    b = 2;
+  }
+  buf = dr_buf[b];
+
+  mpi->planes[0] = buf;
+  mpi->stride[0] = image_scaledstride[0];
+  if (image_format == IMGFMT_NV12) {
+    mpi->planes[1] = buf + image_scaledstride[0] * dr_height;
+    mpi->stride[1] = image_scaledstride[0];
+  } else {
+    mpi->planes[1] = buf + image_scaledstride[0] * dr_height;
+    mpi->planes[2] = mpi->planes[1] + (image_scaledstride[0] >> 1) * (dr_height >> 1);
+    mpi->stride[1] = mpi->stride[2] = image_scaledstride[0] >> 1;
+  }
+  mpi->flags |= MP_IMGFLAG_DIRECT;
+  mpi->priv = (void*)(long)b;
+  return VO_TRUE;
+}
+
+
+/* *********************************
+   draw_image(mpi)
+   *********************************
+   direct rendering: draws a frame decoded into one of our buffers (no scaling needed).
+   other images are passed on to draw_slice()
+   *********************************
+   mpi    ... decoded image
+   *********************************
+   returns VO_TRUE if the frame was drawn, else VO_FALSE
+   *********************************
+   --
+*/
+static int draw_image(mp_image_t* mpi) {
+  uint8_t* planes[3] = { NULL, NULL, NULL };
+  int sx = screen_x, sy = screen_y, w = screen_w, h = screen_h;
+
+  if (!(mpi->flags & MP_IMGFLAG_DIRECT) || !dr_possible)
+    return VO_FALSE;
+
+  if ((frame_skip = frame_checkskip()))
+    return VO_TRUE;
+  fs_nexty = -1;
+
+  planes[0] = mpi->planes[0];
+  if (rot_mode) {
+    unsigned int start = GetTimer();
+
+    drawing_rotated(planes[0], mpi->stride[0]);
+    stage_add(STAGE_DRAWING, start);
+  } else if (drawing_clip(&sx, &sy, &w, &h)) {
+    unsigned int start = GetTimer();
+
+    drawing_algo(planes, sx, sy, w, h);
+    stage_add(STAGE_DRAWING, start);
+  }
+
+  if (!serdisp_flag_async) {
+    if (serdisp_flag_progressive)
+      prog_flush(sdbuf);
+    osd_cleanup((istruecolour) ? tc_stage : sdbuf);
+  }
+
+  stat_drframes++;
+  return VO_TRUE;
+}
+
+
+/* *********************************
+   benchmark_run(frames)
+   *********************************
+   benchmarks the drawing routine selected and the OSD using synthetic frames
+   (gradient, texture and a moving part) in the geometry of the current video and prints ns/pixel and frames/s
+   (pre-rotation: incl. rotating the frame).
+   the display is reset to the background colour afterwards
+   *********************************
+   frames ... number of frames
+   *********************************
+   --
+*/
+static void benchmark_run(int frames) {
+  int f, x, y, c, bpp = image_bpp;
+  int sx = screen_x, sy = screen_y, w = screen_w, h = screen_h;
+  unsigned int start, drawus, osdus;
+  unsigned char* row;
+
+  if (!drawing_clip(&sx, &sy, &w, &h))
+    return;
+
+  drawus = 0;
+  for (f = 0; f < frames; f++) {
+    for (y = 0; y < image_height; y++) {
+      row = image_scaled[0] + y * image_scaledstride[0];
+      for (x = 0; x < image_width; x++) {
+        for (c = 0; c < bpp; c++)
+          row[x * bpp + c] = ((x * MAX_GREYVALUE) / image_width + ((x / 7 + y / 5 + c) % 3) * 20 +
+                              ((y > image_height / 2) ? f * 3 : 0)) & 0xFF;
+      }
+    }
+    fs_nexty = -1;
+    start = GetTimer();
+    if (rot_mode)
+      drawing_rotated(image_scaled[0], image_scaledstride[0]);
+    else
+      drawing_algo(image, sx, sy, w, h);
+    drawus += GetTimer() - start;
+  }
+
+  start = GetTimer();
+  for (f = 0; f < frames; f++) {
+    osd_build(0, (f * 8) & 0xFF);
+    osd_blit((istruecolour) ? tc_stage : sdbuf);
+  }
+  osdus = GetTimer() - start;
+
+  mp_msg(MSGT_VO, MSGL_INFO, "vo_serdisp: benchmark: %d frames %dx%d: drawing: %.2f ns/pixel, %.1f frames/s\n",
+                             frames, w, h, (drawus * 1000.0) / ((double)frames * w * h), 
+                             (drawus) ? (frames * 1000000.0) / drawus : 0.0);
+  mp_msg(MSGT_VO, MSGL_INFO, "vo_serdisp: benchmark: osd progress bar (rebuilt and blitted): %.1f us/call\n", (double)osdus / frames);
+
+  /* reset display content and statistics */
+  if (sdbuf) {
+    sdbuf_clear(sdbuf);
+    sdbuf_invalidate(0, display_height);
+    sdbuf_flush(sdbuf, 0, 0, display_width, display_height);
+  } else {
+    truecolour_clear(tc_stage);
+    sd_clear(&sd_out);
+  }
+  osd_build(-1, 0);
+  osd_blity0 = osd_blity1 = 0;
+  fs_nexty = -1;
+  fs_stablereset();
+  frame_drawnpixels = 0;
+  frame_changedpixels = 0;
+  frame_bytes = 0;
+  memset(stage_frameus, 0, sizeof(stage_frameus));
+  memset(stage_framehit, 0, sizeof(stage_framehit));
+}
+
+
+/* *********************************
+   cache_key(key, size)
+   *********************************
+   builds the key identifying a playback cache: display, options, flags and equalizer values influencing
+   the frames output
+   *********************************
+   key      ... output
+   size     ... size of key
+   *********************************
+   --
+*/
+static void cache_key(char* key, int size) {
+  snprintf(key, size, "%s;w=%d;h=%d;depth=%d;rot=%d;viewmode=%d;dither=%d;matrix=%d;diffusion=%d;hysteresis=%d;"
+                      "threshold=%d;bandpass=%d;gamma=%d:%.3f;brightness=%d;contrast=%d;colourdither=%d",
+                      cache_id, display_width, display_height, display_depth, rot_mode, serdisp_flag_viewmode,
+                      serdisp_flag_algo, serdisp_flag_matrix, serdisp_flag_diffusion, serdisp_flag_hysteresis,
+                      serdisp_flag_threshold, serdisp_flag_bandpass, serdisp_flag_gamma_enable, serdisp_flag_gamma,
+                      serdisp_eq_brightness, serdisp_eq_contrast, tc_dither);
+}
+
+
+/* *********************************
+   cache_close(keep)
+   *********************************
+   stops recording / replaying the playback cache (see sd_cacheclose())
+   *********************************
+   keep   ... recording complete (0: the cache recorded is discarded)
+   *********************************
+   --
+*/
+static void cache_close(int keep) {
+  if (sd_cacheclose(&sd_cache, keep) && serdisp_flag_debug)
+    mp_msg(MSGT_VO, MSGL_INFO, "vo_serdisp: playback cache %s recorded\n", sd_cache.name);
+}
+
 
 /* *********************************
-   drawingalgo_truecolour(image, sx, sy, w, h)
+   cache_start(replay)
    *********************************
-   draws a frame directly on a colour display (without dithering, ...)
+   replays the playback cache if it matches display, flags and equalizer values, else starts recording it
    *********************************
-   image  ... mplayer frame
-   sx/sy  ... phys. start position
-   w/h    ... width/height of frame
+   replay ... 0: record in any case
    *********************************
    --
 */
-static void drawingalgo_truecolour(unsigned char** image, int sx, int sy, int w, int h) {
-  int x, y;
-  int r, g, b;
-  /*long i;*/
+static void cache_start(int replay) {
+  char key[1024];
 
-  int diff_x = sx - screen_x;
-  int diff_y = sy - screen_y;
-
-  int shifty;
-  int shiftx;
+  cache_key(key, sizeof(key));
+  if (replay && !sd_cachemap(&sd_cache, key)) {
+    mp_msg(MSGT_VO, MSGL_INFO, "vo_serdisp: replaying cache %s, frames are not drawn\n", sd_cache.name);
+    return;
+  }
+  if (sd_cacheopen(&sd_cache, key)) {
+    mp_msg(MSGT_VO,MSGL_WARN,"vo_serdisp: unable to record playback cache %s: %s\n", sd_cache.name, strerror(errno));
+    cache_close(0);
+  }
+}
 
-  unsigned char* buffer = image[0];
 
-  if (isclipareasave) {
-    fp_serdisp_cliparea(dd, sx, sy, w, h, diff_x, diff_y, image_width, image_height, 24, buffer);
-  } else {
-    shifty = diff_y * image_width;
-    for (y = 0; y < h; y++) {
-      for (x = 0; x < w; x++) {
-        shiftx = (x + diff_x + shifty );
-        shiftx += shiftx+shiftx;  /* to avoid ' * 3 ' */
-        r = buffer[shiftx++];
-        g = buffer[shiftx++];
-        b = buffer[shiftx  ];
-
-        fp_serdisp_setsdcol(dd, x+sx, y+sy, 0xFF000000 | (r << 16) | (g << 8) | b);
-      }
-      shifty += image_width;
+/* *********************************
+   cache_config()
+   *********************************
+   records the geometry set by config() (display content has been reset to background), replay: checks it against
+   the geometry recorded. if it doesn't match, replaying is stopped (and the cache is recorded anew if no frame has
+   been replayed yet)
+   *********************************
+   --
+*/
+static void cache_config(void) {
+  int32_t geometry[10] = { src_width, src_height, image_format, image_width, image_height,
+                           screen_x, screen_y, screen_w, screen_h, rot_mode };
+  const unsigned char* frame = (sdbuf) ? sdbuf : tc_stage;
+
+  cache_configured = 1;
+  if (sd_cache.data) {
+    if (!sd_cacheconfig(&sd_cache, cache_flips, geometry, sizeof(geometry), frame))
+      return;
+    mp_msg(MSGT_VO, MSGL_INFO, "vo_serdisp: cache %s doesn't match the video, drawing\n", sd_cache.name);
+    if (sd_cache.started) {
+      cache_close(0);
+      return;
     }
+    cache_close(0);
+    cache_start(0);
   }
+  sd_cacheconfig(&sd_cache, cache_flips, geometry, sizeof(geometry), frame);
 }
 
 
+/* *********************************
+   cache_eqchanged()
+   *********************************
+   the equalizer has been changed: before the first frame the cache is selected anew (the key has changed),
+   else recording is aborted / replaying is stopped as the frames wouldn't match anymore
+   *********************************
+   --
+*/
+static void cache_eqchanged(void) {
+  if (!sd_cache.file && !sd_cache.data)
+    return;
+  if (sd_cache.started) {
+    mp_msg(MSGT_VO, MSGL_INFO, "vo_serdisp: equalizer changed, playback cache %s %s\n", sd_cache.name,
+                               (sd_cache.file) ? "not recorded" : "not replayed anymore");
+    cache_close(0);
+    return;
+  }
+  cache_close(0);
+  cache_start(1);
+  if (cache_configured)
+    cache_config();
+}
+
 
+/* *********************************
+   options_check(wall, shmgeometry)
+   *********************************
+   checks combinations of options that don't depend on the display: options that would be ignored silently
+   are reset with a warning
+   (combinations depending on the display, eg. progressive updates on colour displays or rotated video walls,
+   are checked by preinit() once the display is opened)
+   *********************************
+   wall         ... option 'wall'
+   shmgeometry  ... option 'shmgeometry'
+   *********************************
+   options_check() returns 0 if the options can be used, -1 otherwise
+   *********************************
+   --
+*/
+static int options_check(const char* wall, const char* shmgeometry) {
+  if (shmgeometry && wall) {
+    mp_msg(MSGT_VO,MSGL_ERR,"vo_serdisp: options 'wall' and 'shmgeometry' are mutually exclusive "
+                            "(no display is opened if frames are only exported)\n");
+    return -1;
+  }
+  if (serdisp_flag_hysteresis && serdisp_flag_algo != 1) {
+    mp_msg(MSGT_VO,MSGL_WARN,"vo_serdisp: option 'hysteresis' is only valid for error diffusion dithering, ignored\n");
+    serdisp_flag_hysteresis = 0;
+  }
+  if (serdisp_flag_framebytes && !serdisp_flag_progressive) {
+    mp_msg(MSGT_VO,MSGL_WARN,"vo_serdisp: option 'framebytes' is only valid for progressive updates, ignored\n");
+    serdisp_flag_framebytes = 0;
+  }
+  /* the synthetic frames would have to be handed over to the display I/O thread and would be dropped there */
+  if (serdisp_flag_benchmark > 0 && serdisp_flag_async) {
+    mp_msg(MSGT_VO,MSGL_WARN,"vo_serdisp: option 'benchmark' is not supported with asynchronous output, ignored\n");
+    serdisp_flag_benchmark = 0;
+  }
+  return 0;
+}
 
 
 static int preinit(const char *arg) {
   char* dispname = NULL;
   char* sdcddev   = NULL;
   char* serdisp_options   = NULL;    /* serdisplib options (wiring, ... ) */
+  char* statsfile = NULL;            /* file for per-stage timing statistics (csv) */
+  char* wall = NULL;                 /* video wall: panels (<device>@<column>x<row>, separated by ';') */
+  char* shmgeometry = NULL;          /* frames only exported, no display: <width>x<height>x<depth> */
 
   int serdisp_flag_backlight = 1;    /* backlight on (1) or off (0) */
 
@@ -428,11 +3169,31 @@ static int preinit(const char *arg) {
     {"backlight", OPT_ARG_BOOL,  &serdisp_flag_backlight, NULL},
     {"viewmode",  OPT_ARG_INT,   &serdisp_flag_viewmode, NULL},
     {"dither",    OPT_ARG_INT,   &serdisp_flag_algo, NULL},
+    {"matrix",    OPT_ARG_INT,   &serdisp_flag_matrix, NULL},
+    {"diffusion", OPT_ARG_INT,   &serdisp_flag_diffusion, NULL},
+    {"hysteresis", OPT_ARG_INT,  &serdisp_flag_hysteresis, NULL},
     {"threshold", OPT_ARG_INT,   &serdisp_flag_threshold, NULL},
     {"bandpass",  OPT_ARG_INT,   &serdisp_flag_bandpass, NULL},
     {"gamma",     OPT_ARG_FLOAT, &serdisp_flag_gamma, NULL},
     {"help",      OPT_ARG_BOOL,  &serdisp_flag_showhelp, NULL},
     {"debug",     OPT_ARG_BOOL,  &serdisp_flag_debug, NULL},
+    {"async",     OPT_ARG_BOOL,  &serdisp_flag_async, NULL},
+    {"framedrop", OPT_ARG_BOOL,  &serdisp_flag_framedrop, NULL},
+    {"maxfps",    OPT_ARG_INT,   &serdisp_flag_maxfps, NULL},
+    {"threads",   OPT_ARG_INT,   &serdisp_flag_threads, NULL},
+    {"benchmark", OPT_ARG_INT,   &serdisp_flag_benchmark, NULL},
+    {"linkspeed", OPT_ARG_INT,   &serdisp_flag_linkspeed, NULL},
+    {"statsfile", OPT_ARG_MSTRZ, &statsfile, NULL},
+    {"statsinterval", OPT_ARG_INT, &serdisp_flag_statsinterval, NULL},
+    {"colourdither", OPT_ARG_BOOL, &serdisp_flag_colourdither, NULL},
+    {"prerotate", OPT_ARG_BOOL,  &serdisp_flag_prerotate, NULL},
+    {"cache",     OPT_ARG_MSTRZ, &sd_cache.name, NULL},
+    {"progressive", OPT_ARG_BOOL, &serdisp_flag_progressive, NULL},
+    {"framebytes", OPT_ARG_INT,  &serdisp_flag_framebytes, NULL},
+    {"wall",      OPT_ARG_MSTRZ, &wall, NULL},
+    {"shm",       OPT_ARG_MSTRZ, &sd_exp.name, NULL},
+    {"shmslots",  OPT_ARG_INT,   &serdisp_flag_shmslots, NULL},
+    {"shmgeometry", OPT_ARG_MSTRZ, &shmgeometry, NULL},
     {NULL, 0, NULL, NULL}
   };
 
@@ -450,6 +3211,30 @@ static int preinit(const char *arg) {
     my_replace(serdisp_options, '?', ':');
   }
 
+  if (wall) {
+    my_replace(wall, '?', ':');
+  }
+
+  if (options_check(wall, shmgeometry))
+    return VO_ERROR;
+
+  if (statsfile) {
+    int s;
+
+    if (serdisp_flag_statsinterval < 1)
+      serdisp_flag_statsinterval = 1;
+    if (!(stats_file = fopen(statsfile, "w"))) {
+      mp_msg(MSGT_VO,MSGL_ERR,"vo_serdisp: unable to open statistics file %s: %s\n", statsfile, strerror(errno));
+      return VO_ERROR;
+    }
+    fprintf(stats_file, "frames,dropped,pixels,bytes,maxpixels");
+    for (s = 0; s < SD_STAGES; s++) {
+      fprintf(stats_file, ",%s_calls,%s_min,%s_avg,%s_p95,%s_max", stage_stats[s].name, stage_stats[s].name, 
+                          stage_stats[s].name, stage_stats[s].name, stage_stats[s].name);
+    }
+    fprintf(stats_file, "\n");
+  }
+
   if (serdisp_flag_debug) {
     fprintf(stderr, "vo_serdisp.preinit(): name / device:  %s / %s\n", dispname, sdcddev); 
     fprintf(stderr, "vo_serdisp.preinit(): options: %s\n", (serdisp_options) ? serdisp_options : "(none)"); 
@@ -534,7 +3319,7 @@ static int preinit(const char *arg) {
   fp_serdisp_getdepth = (int (*)(void*)) dlsym(sdhnd, "serdisp_getdepth");
   dlerror_die("serdisp_getdepth");
 
-  sd_errormsg = (char*) dlsym(sdhnd, "sd_errormsg");
+  fp_sd_errormsg = (char*) dlsym(sdhnd, "sd_errormsg");
   dlerror_die("sd_errormsg");
 
   fp_serdisp_setsdcol = (void (*)(void*, int, int, uint32_t)) dlsym(sdhnd, "serdisp_setsdcol");
@@ -556,9 +3341,9 @@ static int preinit(const char *arg) {
 #endif /* SERDISP_STATIC */
 
 #ifdef SERDISP_STATIC
-  if (! sdcddev) {
+  if (! sdcddev && ! shmgeometry) {
 #else
-  if (! sdcddev && fp_serdisp_defaultdevice) {
+  if (! sdcddev && ! shmgeometry && fp_serdisp_defaultdevice) {
 #endif
     char* tempdev = (char*) fp_serdisp_defaultdevice(dispname);
     sdcddev = (char*) malloc( strlen(tempdev) + 1);
@@ -571,22 +3356,50 @@ static int preinit(const char *arg) {
     }
   }
 
-  sdcd = fp_SDCONN_open(sdcddev);
+  if (shmgeometry) {
+    /* frames are only exported: no display is opened, the geometry is given */
+    if (!sd_exp.name || !*sd_exp.name ||
+        sscanf(shmgeometry, "%dx%dx%d", &display_width, &display_height, &display_depth) != 3 ||
+        display_width < 1 || display_height < 1 || display_width > 4096 || display_height > 4096 ||
+        (display_depth != 1 && display_depth != 2 && display_depth != 4 && display_depth != 16 && display_depth != 24)) {
+      mp_msg(MSGT_VO,MSGL_ERR,"vo_serdisp: invalid geometry %s (<width>x<height>x<depth>, depth: 1, 2, 4, 16 or 24) "
+                              "or option 'shm' missing\n", shmgeometry);
+      return VO_ERROR;
+    }
+    image_colours = 1 << display_depth;
+    dd = NULL;
+  } else if (wall) {
+    /* video wall: the first panel is used for all queries (all panels are identical) */
+    if (sd_wallopen(&sd_out, wall, dispname, serdisp_options))
+      return VO_ERROR;
+    /* serdisplib would rotate every panel on its own, leaving the panels in the wrong places of the grid */
+    if (fp_serdisp_isoption(sd_out.dd, "ROTATE") && fp_serdisp_getoption(sd_out.dd, "ROTATE", 0)) {
+      mp_msg(MSGT_VO,MSGL_ERR,"vo_serdisp: video wall: rotation (serdisplib option 'rot') is not supported, "
+                              "arrange the grid in native orientation of the panels instead\n");
+      sd_wallclose(&sd_out);
+      return VO_ERROR;
+    }
+    sdcd = sd_out.panels[0].sdcd;
+    dd = sd_out.dd;
+  } else {
+    sdcd = fp_SDCONN_open(sdcddev);
 
-  if (sdcd == (void*)0) {
-    mp_msg(MSGT_VO,MSGL_ERR,"vo_serdisp: unable to open output device %s, additional info: %s\n", sdcddev, sd_errormsg);
-    return VO_ERROR;
-  }
+    if (sdcd == (void*)0) {
+      mp_msg(MSGT_VO,MSGL_ERR,"vo_serdisp: unable to open output device %s, additional info: %s\n", sdcddev, fp_sd_errormsg);
+      return VO_ERROR;
+    }
 
-  dd = fp_serdisp_init(sdcd, dispname, (serdisp_options) ? serdisp_options : "");
+    dd = fp_serdisp_init(sdcd, dispname, (serdisp_options) ? serdisp_options : "");
 
-  if (!dd) {
-    mp_msg(MSGT_VO,MSGL_ERR,"vo_serdisp: unknown display or unable to open %s, additional info: %s\n", dispname, sd_errormsg);
-    return VO_ERROR;
+    if (!dd) {
+      mp_msg(MSGT_VO,MSGL_ERR,"vo_serdisp: unknown display or unable to open %s, additional info: %s\n", dispname, fp_sd_errormsg);
+      return VO_ERROR;
+    }
+    sd_out.dd = dd;
   }
 
   /* pre-init some flags, function pointers, ... */
-  if (fp_serdisp_isoption(dd, "SELFEMITTING") && fp_serdisp_getoption(dd, "SELFEMITTING", 0)) {
+  if (dd && fp_serdisp_isoption(dd, "SELFEMITTING") && fp_serdisp_getoption(dd, "SELFEMITTING", 0)) {
     fg_colour = SD_COL_WHITE;
     bg_colour = SD_COL_BLACK;
   } else {
@@ -594,25 +3407,168 @@ static int preinit(const char *arg) {
     bg_colour = SD_COL_WHITE;
   }
 
-  image_colours = fp_serdisp_getcolours(dd);
+  /* pre-rotation: serdisplib would remap the coordinates of every pixel output, so frames are rotated
+     by the vo instead and serdisplib is reset to native orientation (video wall: rotation has been rejected above) */
+  rot_mode = 0;
+  if (serdisp_flag_prerotate && !sd_out.count && dd && fp_serdisp_isoption(dd, "ROTATE")) {
+    rot_mode = sd_rotdegrees(fp_serdisp_getoption(dd, "ROTATE", 0));
+    if (rot_mode)
+      fp_serdisp_setoption(dd, "ROTATE", 0);
+  }
+
+  if (dd) {
+    image_colours = fp_serdisp_getcolours(dd);
+    display_width = fp_serdisp_getwidth(dd);
+    display_height = fp_serdisp_getheight(dd);
+    display_depth = fp_serdisp_getdepth(dd);
+  }
+  if (sd_out.count) {
+    display_width = sd_out.panel_width * sd_out.cols;
+    display_height = sd_out.panel_height * sd_out.rows;
+  }
+  sd_out.depth = display_depth;
+  sd_out.linkspeed = serdisp_flag_linkspeed;
+  view_width = (rot_mode == 90 || rot_mode == 270) ? display_height : display_width;
+  view_height = (rot_mode == 90 || rot_mode == 270) ? display_width : display_height;
 
   /* colour depth >= 8 ==> truecolour  (even if display w/ 256 grey-levels) */
-  if (fp_serdisp_getdepth(dd) >= 8) {
+  if (display_depth >= 8) {
     istruecolour = 1;
   }
 
+  /* 12/16 bit colour displays: frames are composed and output in rgb565 (serdisplib converts to 12 bit) */
+  tc_bpp = 3;
+  tc_dither = 0;
+  if (istruecolour && (display_depth == 12 || display_depth == 16)) {
+    int rank[16], i;
+
+    tc_bpp = 2;
+    tc_dither = serdisp_flag_colourdither;
+    sd_orderedbayer(rank, 4);
+    for (i = 0; i < 16; i++)
+      tc_ditherthr[i >> 2][i & 3] = rank[i];
+    if (!(tone_lut565 = (uint16_t*)malloc(65536 * sizeof(uint16_t)))) {
+      mp_msg(MSGT_VO,MSGL_ERR,"vo_serdisp: unable to allocate tone table\n");
+      return VO_ERROR;
+    }
+    if (serdisp_flag_debug) {
+      mp_msg(MSGT_VO, MSGL_INFO, "vo_serdisp: colour depth %d: rgb565 output, %s\n", display_depth,
+                                 (tc_dither) ? "ordered dithering (bayer 4x4)" : "no dithering");
+    }
+  }
+
+  if (!istruecolour) {
+    int i;
+
+    /* packed frame buffer: use native depth if it is a power of two, else one byte per pixel */
+    switch (display_depth) {
+      case 1:  sdbuf_dshift = 0; break;
+      case 2:  sdbuf_dshift = 1; break;
+      case 4:  sdbuf_dshift = 2; break;
+      default: sdbuf_dshift = 3;
+    }
+    sdbuf_depth = 1 << sdbuf_dshift;
+    sdbuf_xshift = 3 - sdbuf_dshift;
+    sdbuf_xmask = (1 << sdbuf_xshift) - 1;
+    sdbuf_idxmask = (1 << sdbuf_depth) - 1;
+    sdbuf_stride = (display_width * sdbuf_depth + 7) >> 3;
+
+    for (i = 0; i <= MAX_GREYVALUE; i++)
+      grey2idx[i] = (i * (image_colours - 1) + (MAX_GREYVALUE >> 1)) / MAX_GREYVALUE;
+    for (i = 0; i < image_colours && i < 256; i++)
+      idx2grey[i] = (i * MAX_GREYVALUE) / (image_colours - 1);
+
+    sdbuf_bgidx = (bg_colour == SD_COL_WHITE) ? image_colours - 1 : 0;
+
+    for (i = 0; i < 256; i++) {
+      int b;
+      sdbuf_diffpixels[i] = 0;
+      for (b = 0; b < 8; b += sdbuf_depth)
+        if ((i >> b) & sdbuf_idxmask)
+          sdbuf_diffpixels[i]++;
+    }
+
+    sdbuf = (unsigned char*)malloc(sdbuf_stride * display_height);
+    sdbuf_prev = (unsigned char*)malloc(sdbuf_stride * display_height);
+    sdbuf_rowinvalid = (unsigned char*)calloc(display_height, 1);
+    if (!sdbuf || !sdbuf_prev || !sdbuf_rowinvalid) {
+      mp_msg(MSGT_VO,MSGL_ERR,"vo_serdisp: unable to allocate packed frame buffer\n");
+      return VO_ERROR;
+    }
+    /* pre-fill with background colour (display has been cleared) */
+    sdbuf_clear(sdbuf);
+    memcpy(sdbuf_prev, sdbuf, sdbuf_stride * display_height);
+  }
+
+
+  /* check whether it is save to use serdisp_cliparea() */
+  /* greyscale/monochrome: the packed frame buffer may only be used if it is stored in native depth */
+  /* truecolour: full display rows of the staging buffer are output, so any aspect ratio and viewmode is ok */
+  isclipareasave = 1;
+  if (
+#ifndef SERDISP_STATIC
+    (! fp_serdisp_cliparea) ||
+#endif
+    (!istruecolour && (sdbuf_depth != display_depth) ) ||
+    (!istruecolour && sd_out.count && ((sd_out.panel_width * sdbuf_depth) & 7))   /* panels don't start at byte boundaries */
+  ) {
+    isclipareasave = 0;
+  }
+
+  if (serdisp_flag_progressive) {
+    if (istruecolour) {
+      mp_msg(MSGT_VO,MSGL_WARN,"vo_serdisp: progressive updates are only supported on monochrome and greyscale displays\n");
+      serdisp_flag_progressive = 0;
+    } else if (sd_proginit(&sd_prog, display_height)) {
+      mp_msg(MSGT_VO,MSGL_ERR,"vo_serdisp: unable to allocate buffers for progressive updates\n");
+      return VO_ERROR;
+    }
+  }
+
+  tone_build();
 
-  fp_serdisp_clear(dd);
-  fp_serdisp_setoption(dd, "BACKLIGHT", serdisp_flag_backlight);
+  sd_clear(&sd_out);
+  if (sd_out.count) {
+    int p;
 
+    for (p = 0; p < sd_out.count; p++)
+      fp_serdisp_setoption(sd_out.panels[p].dd, "BACKLIGHT", serdisp_flag_backlight);
+  } else if (dd) {
+    fp_serdisp_setoption(dd, "BACKLIGHT", serdisp_flag_backlight);
+  }
+
+
+  /* drawing threads */
+  if (serdisp_flag_threads > SD_MAXTHREADS) {
+    mp_msg(MSGT_VO,MSGL_WARN,"vo_serdisp: max. %d threads supported\n", SD_MAXTHREADS);
+    serdisp_flag_threads = SD_MAXTHREADS;
+  }
+#if HAVE_PTHREADS
+  pool_quit = 0;
+  for (pool_started = 0; pool_started < serdisp_flag_threads - 1; pool_started++) {
+    if (pthread_create(&pool_threads[pool_started], NULL, pool_thread, (void*)(long)(pool_started + 1))) {
+      mp_msg(MSGT_VO,MSGL_WARN,"vo_serdisp: unable to create drawing thread, using %d thread(s)\n", pool_started + 1);
+      break;
+    }
+  }
+  pool_size = pool_started + 1;
+#else
+  if (serdisp_flag_threads > 1)
+    mp_msg(MSGT_VO,MSGL_WARN,"vo_serdisp: no thread support, using one drawing thread\n");
+#endif
 
-  image[0] = (uint8_t*)malloc( fp_serdisp_getwidth(dd) * fp_serdisp_getheight(dd) * 4);
+  /* buffers for scaled frames are allocated in config() (geometry of the video), staging buffer: display geometry */
+  image[0] = NULL;
   image[1] = NULL;
   image[2] = NULL;
 
-  if (!image[0]) {
-    mp_msg(MSGT_VO,MSGL_ERR,"vo_serdisp: unable to allocate array for image\n");
-    return VO_ERROR;
+  if (istruecolour) {
+    tc_stage = (unsigned char*)malloc(display_width * display_height * tc_bpp);
+    if (!tc_stage) {
+      mp_msg(MSGT_VO,MSGL_ERR,"vo_serdisp: unable to allocate staging buffer\n");
+      return VO_ERROR;
+    }
+    truecolour_clear(tc_stage);
   }
 
   if (!istruecolour) {
@@ -620,19 +3576,70 @@ static int preinit(const char *arg) {
       case 0:
        drawing_algo = &drawingalgo_directgrey;
        break;
-      case 1:
-       drawing_algo = &drawingalgo_dithergrey;
+      case 2:
+       if (ordered_init()) {
+         mp_msg(MSGT_VO,MSGL_ERR,"vo_serdisp: unable to allocate buffers for ordered dithering\n");
+         return VO_ERROR;
+       }
+       if (serdisp_flag_debug) {
+         mp_msg(MSGT_VO, MSGL_INFO, "vo_serdisp: ordered dithering: matrix %dx%d, kernel: %s\n", 
+                                    ordered_size, ordered_size, ordered_kernelname);
+       }
+       drawing_algo = &drawingalgo_ordered;
        break;
       default:
+       if (fs_init()) {
+         mp_msg(MSGT_VO,MSGL_ERR,"vo_serdisp: unable to allocate buffers for error diffusion dithering\n");
+         return VO_ERROR;
+       }
+       if (serdisp_flag_debug) {
+         mp_msg(MSGT_VO, MSGL_INFO, "vo_serdisp: error diffusion dithering: %s, %d thread(s)\n", 
+                                    dither_kernels[serdisp_flag_diffusion].name,
+                                    (dither_kernels[serdisp_flag_diffusion].rows == 1) ? pool_size : 1);
+       }
        drawing_algo = &drawingalgo_dithergrey;
     }
   } else {
     drawing_algo = &drawingalgo_truecolour;
   }
 
+  if (serdisp_flag_async) {
+#if HAVE_PTHREADS
+    /* mailbox and front buffer: same size as the buffer that is drawn into */
+    int bufsize = (istruecolour) ? display_width * display_height * tc_bpp : sdbuf_stride * display_height;
+
+    async_pendingbuf = (unsigned char*)malloc(bufsize);
+    async_frontbuf = (unsigned char*)malloc(bufsize);
+    if (!async_pendingbuf || !async_frontbuf) {
+      mp_msg(MSGT_VO,MSGL_ERR,"vo_serdisp: unable to allocate buffers for asynchronous output\n");
+      return VO_ERROR;
+    }
+    if (!istruecolour) {
+      sdbuf_clear(async_pendingbuf);
+      sdbuf_clear(async_frontbuf);
+    } else {
+      truecolour_clear(async_pendingbuf);
+      truecolour_clear(async_frontbuf);
+    }
+
+    async_quit = 0;
+    if (pthread_create(&async_thread, NULL, async_outputthread, NULL)) {
+      mp_msg(MSGT_VO,MSGL_WARN,"vo_serdisp: unable to create display I/O thread, using synchronous output\n");
+      serdisp_flag_async = 0;
+    } else {
+      async_started = 1;
+      if (istruecolour)
+        drawing_algo = &drawingalgo_deferred;
+    }
+#else
+    mp_msg(MSGT_VO,MSGL_WARN,"vo_serdisp: no thread support, using synchronous output\n");
+    serdisp_flag_async = 0;
+#endif
+  }
+
   /* osd size and position */
   /* osd height is relative to display height */
-  osd_height = fp_serdisp_getheight(dd) / SD_OSD_HIPERCENT;
+  osd_height = view_height / SD_OSD_HIPERCENT;
   osd_bar_height = osd_height - 2 * osd_margin;
 
   if (osd_bar_height < SD_OSD_MINHEIGHT) {
@@ -640,7 +3647,49 @@ static int preinit(const char *arg) {
     osd_margin = 1;
     osd_height = osd_bar_height + osd_margin * 2;
   }
-  osd_posy = (fp_serdisp_getheight(dd) - osd_height) ;
+  osd_posy = (view_height - osd_height) ;
+
+  /* cached osd overlay */
+  osd_ovlstride = (istruecolour) ? display_width * tc_bpp : sdbuf_stride;
+  osd_maskstride = (istruecolour) ? display_width : sdbuf_stride;
+  osd_layer = (unsigned char*)malloc(display_width * display_height);
+  osd_layeralpha = (unsigned char*)calloc(display_width * display_height, 1);
+  osd_ovl = (unsigned char*)malloc(osd_ovlstride * display_height);
+  osd_ovlmask = (unsigned char*)malloc(osd_maskstride * display_height);
+  osd_comp = (unsigned char*)malloc(osd_ovlstride * display_height);
+  if (rot_mode)
+    osd_rotrow = (unsigned char*)malloc(display_width * 2);
+  if (!osd_layer || !osd_layeralpha || !osd_ovl || !osd_ovlmask || !osd_comp || (rot_mode && !osd_rotrow)) {
+    mp_msg(MSGT_VO,MSGL_ERR,"vo_serdisp: unable to allocate osd overlay\n");
+    return VO_ERROR;
+  }
+
+  /* frame export */
+  if (sd_exp.name && *sd_exp.name) {
+    if (sd_exportopen(&sd_exp, display_width, display_height, (istruecolour) ? tc_bpp * 8 : sdbuf_depth, image_colours,
+                      (istruecolour) ? display_width * tc_bpp : sdbuf_stride, serdisp_flag_shmslots)) {
+      mp_msg(MSGT_VO,MSGL_ERR,"vo_serdisp: unable to create shared memory object %s: %s\n", sd_exp.name, strerror(errno));
+      return VO_ERROR;
+    }
+    if (serdisp_flag_debug)
+      mp_msg(MSGT_VO, MSGL_INFO, "vo_serdisp: frames exported to shared memory object %s (%d slots, %d bytes per slot)\n",
+                                 sd_exp.name, (int)sd_exp.hdr->slots, (int)sd_exp.hdr->slotsize);
+  }
+
+  /* playback cache: replay if valid (frames are then output by flip_page() instead of being drawn), else record */
+  cache_flips = 0;
+  cache_configured = 0;
+  if (sd_cache.name && *sd_cache.name) {
+    char id[768];
+
+    snprintf(id, sizeof(id), "name=%s;device=%s;options=%s", (dispname) ? dispname : "",
+                             (wall) ? wall : ((sdcddev) ? sdcddev : ""), (serdisp_options) ? serdisp_options : "");
+    cache_id = strdup(id);
+    sd_cache.rowbytes = (istruecolour) ? display_width * tc_bpp : sdbuf_stride;
+    sd_cache.height = display_height;
+    if (cache_id)
+      cache_start(1);
+  }
 
   return 0;
 }
@@ -659,15 +3708,26 @@ config(uint32_t width, uint32_t height, uint32_t d_width,
  
   /* normalised width and height. width = 100, height is calculated using pixel aspect ratio and pixel geometry */
   int aspect_w, aspect_h;
+  int pixelaspect = (dd) ? fp_serdisp_getpixelaspect(dd) : 100;
+  int swapped = (rot_mode == 90 || rot_mode == 270);
+
+#if HAVE_PTHREADS
+  /* display I/O thread must not access geometry and buffers while they are changed */
+  if (async_started)
+    async_wait();
+#endif
 
   image_format = format;
 
   aspect_save_orig(width,height);
   aspect_save_prescale(d_width,d_height);
 
-  /* calculate display area dimension that will be used. also do aspect-ratio correction for displays with non-quadratic pixels */
+  /* calculate display area dimension that will be used. also do aspect-ratio correction for displays with non-quadratic pixels.
+     the frame is fitted into the display as seen by the viewer (pre-rotation: pixel aspect ratio is inverted if swapped) */
+  if (swapped)
+    pixelaspect = 10000 / pixelaspect;
   aspect_w = 100;
-  aspect_h = (fp_serdisp_getpixelaspect(dd) * fp_serdisp_getheight(dd)) / fp_serdisp_getwidth(dd);
+  aspect_h = (pixelaspect * view_height) / view_width;
 
 
   fact_w = (double)d_width  / (double) aspect_w;
@@ -684,61 +3744,138 @@ config(uint32_t width, uint32_t height, uint32_t d_width,
       fact = (fact_w > fact_h) ? fact_w : fact_h;
   }
 
-  screen_w = (int)( ((double)d_width / fact) * ( (double)(fp_serdisp_getwidth(dd)) / (double)aspect_w)  );
-  screen_h = (int)( ((double)d_height / fact) * ( (double)(fp_serdisp_getheight(dd)) / (double)aspect_h)  );
+  image_width = (int)( ((double)d_width / fact) * ( (double)view_width / (double)aspect_w)  );
+  image_height = (int)( ((double)d_height / fact) * ( (double)view_height / (double)aspect_h)  );
 
   if (serdisp_flag_viewmode == 0) {
     /* clip potential rounding errors */
-    if (screen_w > fp_serdisp_getwidth(dd)) screen_w = fp_serdisp_getwidth(dd);
-    if (screen_h > fp_serdisp_getheight(dd)) screen_h = fp_serdisp_getheight(dd);
+    if (image_width > view_width) image_width = view_width;
+    if (image_height > view_height) image_height = view_height;
   }
 
-  /* check whether it is save to use serdisp_cliparea() */
-  if (
-#ifndef SERDISP_STATIC
-    (! fp_serdisp_cliparea) ||
-#endif
-    (istruecolour && (screen_w != fp_serdisp_getwidth(dd)) )
-  ) {
-    isclipareasave = 0;
+  /* screen area: phys. display orientation */
+  screen_w = (swapped) ? image_height : image_width;
+  screen_h = (swapped) ? image_width : image_height;
+
+  /* centred as seen by the viewer (pre-rotation: rounding as if serdisplib rotated the frame) */
+  screen_x = (view_width - image_width) >> 1;
+  screen_y = (view_height - image_height) >> 1;
+  switch (rot_mode) {
+    case 90: {
+      int x = screen_x;
+
+      screen_x = display_width - screen_y - screen_w;
+      screen_y = x;
+      break;
+    }
+    case 180:
+      screen_x = display_width - screen_x - screen_w;
+      screen_y = display_height - screen_y - screen_h;
+      break;
+    case 270: {
+      int x = screen_x;
+
+      screen_x = screen_y;
+      screen_y = display_height - x - screen_h;
+      break;
+    }
   }
 
-  screen_x = (fp_serdisp_getwidth(dd) -screen_w) >> 1;
-  screen_y = (fp_serdisp_getheight(dd)-screen_h) >> 1;
+  /* geometry may have changed: reset packed frame buffer to background colour and output it completely */
+  if (sdbuf) {
+    sdbuf_clear(sdbuf);
+    fs_stablereset();
+#if HAVE_PTHREADS
+    if (async_started) {
+      sdbuf_clear(async_pendingbuf);
+      sdbuf_clear(async_frontbuf);
+    }
+#endif
+    sdbuf_invalidate(0, display_height);
+    sdbuf_flush(sdbuf, 0, 0, display_width, display_height);
+  } else {
+    truecolour_clear(tc_stage);
+#if HAVE_PTHREADS
+    if (async_started) {
+      truecolour_clear(async_pendingbuf);
+      truecolour_clear(async_frontbuf);
+    }
+#endif
+    truecolour_output(tc_stage, 0, 0, display_width, display_height);
+  }
 
   src_width = width;
   src_height = height;
-  image_width = screen_w;
-  image_height = screen_h;
 
   if(sws) 
     sws_freeContext(sws);
 
-  sws = sws_getContextFromCmdLine(src_width,src_height,image_format,
-  image_width,image_height, (istruecolour) ? IMGFMT_RGB24 : IMGFMT_Y8);
+  /* greyscale/monochrome and yuv input: scale the luma plane only, chroma is ignored */
+  switch (image_format) {
+    case IMGFMT_YV12:
+    case IMGFMT_I420:
+    case IMGFMT_IYUV:
+    case IMGFMT_NV12:
+      if (image_lumaonly != !istruecolour) {
+        image_lumaonly = !istruecolour;
+        tone_build();
+      }
+      break;
+    default:
+      if (image_lumaonly) {
+        image_lumaonly = 0;
+        tone_build();
+      }
+  }
+
+  /* rgb565 (IMGFMT_BGR16) if it is the format of the staging buffer */
+  sws = sws_getContextFromCmdLine(src_width,src_height,(image_lumaonly) ? IMGFMT_Y8 : image_format,
+  image_width,image_height, (istruecolour) ? ((tc_bpp == 2 && !tc_dither) ? IMGFMT_BGR16 : IMGFMT_RGB24) : IMGFMT_Y8);
 
+  image_bpp = (istruecolour) ? ((tc_bpp == 2 && !tc_dither) ? 2 : 3) : 1;
+  image_scaledstride[1] = 0;
+  image_scaledstride[2] = 0;
   if (istruecolour) {
-    image_stride[0] = image_width * 3;
+    image_stride[0] = screen_w * image_bpp;
     image_stride[1] = 0; 
     image_stride[2] = 0;
   } else {
-    image_stride[0] = image_width;
+    /* aligned stride: same layout for scaled frames and direct rendering buffers */
+    image_stride[0] = (screen_w + 31) & ~31;
     image_stride[1] = 0; 
     image_stride[2] = 0;
   }
+  if (image_alloc() < 0) {
+    mp_msg(MSGT_VO,MSGL_ERR,"vo_serdisp: unable to allocate array for image\n");
+    return -1;
+  }
+  dr_init();
+  fused_init();
+  band_init();
 
   if (serdisp_flag_debug) {
     mp_msg(MSGT_VO, MSGL_INFO, "vo_serdisp.config(): serdisplib version: %d.%d\n", SERDISP_VERSION_GET_MAJOR(serdisp_version), SERDISP_VERSION_GET_MINOR(serdisp_version)); 
     mp_msg(MSGT_VO, MSGL_INFO, "vo_serdisp.config(): incoming params: width/height: %d/%d -> d_width/d_height: %d/%d  flags: %04x\n", 
                                 width, height, d_width, d_height, flags);
     mp_msg(MSGT_VO, MSGL_INFO, "vo_serdisp.config(): + aspect ratio corr.: src_w/_h: %d/%d -> image_w/_h: %d/%d  pixel asp.ratio: %.2f\n", 
-                               src_width, src_height, image_width, image_height, (fp_serdisp_getpixelaspect(dd) / 100.0));
+                               src_width, src_height, image_width, image_height, (((dd) ? fp_serdisp_getpixelaspect(dd) : 100) / 100.0));
     mp_msg(MSGT_VO, MSGL_INFO, "vo_serdisp.config(): dest geometry: x/y/w/h: %d/%d/%d/%d (factor: %f)\n", screen_x, screen_y, screen_w, screen_h, fact);
-    mp_msg(MSGT_VO, MSGL_INFO, "vo_serdisp.config(): phys. display dimensions: w/h: %d/%d\n", fp_serdisp_getwidth(dd), fp_serdisp_getheight(dd));
+    mp_msg(MSGT_VO, MSGL_INFO, "vo_serdisp.config(): phys. display dimensions: w/h: %d/%d, pre-rotation: %d degrees\n", display_width, display_height, rot_mode);
     mp_msg(MSGT_VO, MSGL_INFO, "vo_serdisp.config(): flags: algo: %d, threshold: %d, gamma[enabled=%d]: %.2f, viewmode: %d, cliparea: %d\n", 
                                serdisp_flag_algo, serdisp_flag_threshold, serdisp_flag_gamma_enable, serdisp_flag_gamma, serdisp_flag_viewmode, isclipareasave);
+    mp_msg(MSGT_VO, MSGL_INFO, "vo_serdisp.config(): direct rendering possible: %d, fused downscaling: %d, bands: %d\n", dr_possible, fused_enabled, band_count);
+  }
+
+  if (serdisp_flag_benchmark > 0) {
+#if HAVE_PTHREADS
+    if (!serdisp_flag_async)
+#endif
+      benchmark_run(serdisp_flag_benchmark);
   }
 
+  if (sd_cache.file || sd_cache.data)
+    cache_config();
+
   return 0;
 }
 
@@ -752,9 +3889,17 @@ query_format(uint32_t format) {
      */
 
 /* taken from vo_dga.c */
-    /* serdisplib only supports RGB-like colour spaces, no YUV ones */
+    /* serdisplib only supports RGB-like colour spaces. yuv input is converted by our sws
+       (greyscale/monochrome displays: luma plane only) */
     if ((format & IMGFMT_BGR_MASK) == IMGFMT_BGR ) {
-        return VFCAP_CSP_SUPPORTED | VFCAP_SWSCALE | VFCAP_OSD;
+        return VFCAP_CSP_SUPPORTED | VFCAP_SWSCALE | VFCAP_OSD | VFCAP_ACCEPT_STRIDE;
+    }
+    switch (format) {
+      case IMGFMT_YV12:
+      case IMGFMT_I420:
+      case IMGFMT_IYUV:
+      case IMGFMT_NV12:
+        return VFCAP_CSP_SUPPORTED | VFCAP_SWSCALE | VFCAP_OSD | VFCAP_ACCEPT_STRIDE;
     }
     return 0;
 }
@@ -762,6 +3907,12 @@ query_format(uint32_t format) {
 static int 
 draw_frame(uint8_t *src[]) {
   int stride[3] = { 0 , 0 , 0 };
+  int sx = screen_x, sy = screen_y, w = screen_w, h = screen_h;
+  unsigned int start;
+
+  if ((frame_skip = frame_checkskip()))
+    return 0;
+  fs_nexty = -1;
 
   switch(image_format) {
   case IMGFMT_BGR15:
@@ -775,25 +3926,42 @@ draw_frame(uint8_t *src[]) {
   case IMGFMT_BGR32:
     stride[0] = src_width*4;
     break;
+  case IMGFMT_YV12:
+  case IMGFMT_I420:
+  case IMGFMT_IYUV:
+    stride[0] = src_width;
+    stride[1] = stride[2] = src_width/2;
+    break;
+  case IMGFMT_NV12:
+    stride[0] = stride[1] = src_width;
+    break;
   }
 
-  sws_scale(sws,(const uint8_t* const *)src,stride,0,src_height,image,image_stride); 
-
-  drawing_algo(image, screen_x, screen_y, screen_w, screen_h);
-
-  /* small hack which cleans potential remainders of a previously drawn OSD */
-  /* the drawing routines might not use the hole display area for drawing a frame (because of aspect ratio a.s.o.), 
-     but the OSD always uses the bottom of the display. 
-     parts of the OSD might not be reached by the drawing routines() and because of this ugly remainders would occur.
-     this hack simply fills the space not reached by the drawing routines using the background colour */
-  if (osd_updated) {  /* only apply the hack after an OSD draw event */
-    int i,j, start_j = (screen_y >= 0 && (screen_y + screen_h) > osd_posy) ? (screen_y + screen_h) : osd_posy;
-    for (j = start_j; j < osd_posy + osd_height; j++) {
-      for (i = 0 ; i < fp_serdisp_getwidth(dd); i++) {
-        fp_serdisp_setsdcol(dd, i, j, bg_colour);
-      }
+  start = GetTimer();
+  if (fused_enabled) {
+    fused_rows(src[0], stride[0], 0, src_height);
+    stage_add(STAGE_DRAWING, start);
+  } else if (band_count) {
+    band_frame(src, stride);
+  } else {
+    sws_scale(sws,(const uint8_t* const *)src,stride,0,src_height,image_scaled,image_scaledstride); 
+    stage_add(STAGE_SWS, start);
+
+    if (rot_mode) {
+      start = GetTimer();
+      drawing_rotated(image_scaled[0], image_scaledstride[0]);
+      stage_add(STAGE_DRAWING, start);
+    } else if (drawing_clip(&sx, &sy, &w, &h)) {
+      start = GetTimer();
+      drawing_algo(image, sx, sy, w, h);
+      stage_add(STAGE_DRAWING, start);
     }
-    osd_updated = 0;  /* do this only once */
+  }
+
+  if (!serdisp_flag_async) {
+    if (serdisp_flag_progressive)
+      prog_flush(sdbuf);
+    osd_cleanup((istruecolour) ? tc_stage : sdbuf);
   }
 
   return 0;
@@ -802,13 +3970,53 @@ draw_frame(uint8_t *src[]) {
 
 static int 
 draw_slice(uint8_t *src[], int stride[], int w, int h, int x, int y) {
-  int dx1 = screen_x + (x * screen_w / src_width);
-  int dy1 = screen_y + (y * screen_h / src_height);
-  int dx2 = screen_x + ((x+w) * screen_w / src_width);
-  int dy2 = screen_y + ((y+h) * screen_h / src_height);
+  int dx = screen_x, dy, dw = screen_w, dh;
+  unsigned int start;
+
+  /* first slice of a frame: decide whether the frame is to be skipped, start a new frame */
+  if (y == 0) {
+    frame_skip = frame_checkskip();
+    slice_outy = 0;
+    fs_nexty = -1;
+  }
+  if (frame_skip)
+    return 0;
+
+  start = GetTimer();
+  if (fused_enabled) {
+    fused_rows(src[0], stride[0], y, h);
+    stage_add(STAGE_DRAWING, start);
+  } else if (band_count && y == 0 && h >= src_height) {
+    /* complete frame passed as one slice */
+    band_frame(src, stride);
+  } else {
+    /* sws returns the number of rows of the scaled frame that are complete after this slice
+       (may differ from the slice height because of the scaling filter) */
+    dh = sws_scale(sws, (const uint8_t* const*) src, stride, y, h, image_scaled, image_scaledstride);
+    stage_add(STAGE_SWS, start);
+    dy = screen_y + slice_outy;
+    slice_outy += dh;
+
+    if (rot_mode) {
+      /* pre-rotation: slices become columns or are reversed, the frame is drawn with the last slice */
+      if (y + h >= src_height) {
+        start = GetTimer();
+        drawing_rotated(image_scaled[0], image_scaledstride[0]);
+        stage_add(STAGE_DRAWING, start);
+      }
+    } else if (drawing_clip(&dx, &dy, &dw, &dh)) {
+      start = GetTimer();
+      drawing_algo(image, dx, dy, dw, dh);
+      stage_add(STAGE_DRAWING, start);
+    }
+  }
 
-  sws_scale(sws, (const uint8_t* const*) src, stride, y, h, image, image_stride);
-  drawing_algo(image, dx1, dy1, dx2-dx1, dy2-dy1);
+  /* last slice of a frame */
+  if (y + h >= src_height && !serdisp_flag_async) {
+    if (serdisp_flag_progressive)
+      prog_flush(sdbuf);
+    osd_cleanup((istruecolour) ? tc_stage : sdbuf);
+  }
 
   return 0;
 }
@@ -816,9 +4024,51 @@ draw_slice(uint8_t *src[], int stride[], int w, int h, int x, int y) {
 
 static void 
 flip_page(void) {
-
+  uint32_t flip = cache_flips++;
+  int replayed = 0;
+
+  /* playback cache: the frame hasn't been drawn (see frame_checkskip()), output the one recorded instead */
+  if (sd_cache.data && (replayed = sd_cachereplay(&sd_cache, flip)) < 0) {
+    mp_msg(MSGT_VO, MSGL_INFO, "vo_serdisp: end of cache %s, drawing\n", sd_cache.name);
+    cache_close(0);
+    replayed = 0;
+  }
+  /* progressive updates: rows carried over are output even if the frame replayed doesn't change */
+  if (sd_cache.data && !replayed && serdisp_flag_progressive && sd_cache.started)
+    replayed = 1;
+
+  if (frame_skip && !replayed) {
+    stat_framesskipped++;
+    frame_skip = 0;
+    return;
+  }
+  frame_skip = 0;
+
+  if (replayed) {
+    memcpy((istruecolour) ? tc_stage : sdbuf, sd_cache.prev, sd_cache.rowbytes * display_height);
+    if (!serdisp_flag_async) {
+      if (istruecolour)
+        truecolour_output(tc_stage, 0, 0, display_width, display_height);
+      else if (serdisp_flag_progressive)
+        prog_flush(sdbuf);
+      else
+        sdbuf_flush(sdbuf, 0, 0, display_width, display_height);
+    }
+  } else {
+    stage_commit(STAGE_SWS, STAGE_DRAWING);
+    if (sd_cache.file)
+      sd_cacheframe(&sd_cache, flip, (istruecolour) ? tc_stage : sdbuf);
+  }
+  if (sd_exp.hdr)
+    sd_exportframe(&sd_exp, (istruecolour) ? tc_stage : sdbuf);
+#if HAVE_PTHREADS
+  if (serdisp_flag_async) {
+    async_handover();
+    return;
+  }
+#endif
   /* print out */
-  fp_serdisp_update(dd);
+  output_update();
 }
 
 
@@ -827,43 +4077,186 @@ uninit(void) {
   /*
    * THE END
    */
-  if (image[0]) {
-    free(image[0]);
-    image[0] = 0;
+#if HAVE_PTHREADS
+  if (async_started) {
+    /* let the display I/O thread output the remaining frame and terminate */
+    pthread_mutex_lock(&async_mutex);
+    async_quit = 1;
+    pthread_cond_broadcast(&async_cond);
+    pthread_mutex_unlock(&async_mutex);
+    pthread_join(async_thread, NULL);
+    async_started = 0;
+  }
+  if (async_pendingbuf) {
+    free(async_pendingbuf);
+    async_pendingbuf = NULL;
+  }
+  if (async_frontbuf) {
+    free(async_frontbuf);
+    async_frontbuf = NULL;
+  }
+  if (pool_started) {
+    int t;
+
+    pthread_mutex_lock(&pool_mutex);
+    pool_quit = 1;
+    pthread_cond_broadcast(&pool_cond);
+    pthread_mutex_unlock(&pool_mutex);
+    for (t = 0; t < pool_started; t++)
+      pthread_join(pool_threads[t], NULL);
+    pool_started = 0;
+    pool_size = 1;
+  }
+#endif
+  band_free();
+  image_free();
+  if (tc_stage) {
+    free(tc_stage);
+    tc_stage = NULL;
+  }
+  if (tone_lut565) {
+    free(tone_lut565);
+    tone_lut565 = NULL;
+  }
+  if (serdisp_flag_debug && stat_frames) {
+    mp_msg(MSGT_VO, MSGL_INFO, "vo_serdisp: frames: %lu, skipped updates: %lu, changed pixels: %.1f%%, dropped by async. output: %lu\n", 
+                               stat_frames, stat_skippedupdates, 
+                               (stat_drawnpixels) ? (100.0 * stat_changedpixels / stat_drawnpixels) : 0.0,
+                               stat_asyncdropped);
+    mp_msg(MSGT_VO, MSGL_INFO, "vo_serdisp: effective fps: %.2f, dropped by frame skipping: %lu, avg. update time: %.2f ms\n", 
+                               (stat_outputus) ? ((stat_frames - 1) * 1000000.0 / stat_outputus) : 0.0,
+                               stat_framesskipped, link_avgus / 1000.0);
+    mp_msg(MSGT_VO, MSGL_INFO, "vo_serdisp: frames drawn using direct rendering: %lu, bytes pushed: %llu (%.1f per frame)\n", 
+                               stat_drframes, stat_bytes, (double)stat_bytes / stat_frames);
+    if (serdisp_flag_progressive)
+      mp_msg(MSGT_VO, MSGL_INFO, "vo_serdisp: progressive updates: budget: %lu bytes per frame, row groups carried over: %lu\n",
+                                 prog_budget(), stat_progcarried);
+  }
+  if (stat_frames)
+    stats_print((serdisp_flag_debug) ? MSGL_INFO : MSGL_V);
+  if (stats_file) {
+    if (stat_frames % serdisp_flag_statsinterval)
+      stats_writecsv();   /* last line: totals */
+    fclose(stats_file);
+    stats_file = NULL;
+  }
+  cache_close(1);
+  if (sd_cache.name) {
+    free(sd_cache.name);
+    sd_cache.name = NULL;
+  }
+  if (cache_id) {
+    free(cache_id);
+    cache_id = NULL;
+  }
+  sd_exportclose(&sd_exp);
+  if (sd_exp.name) {
+    free(sd_exp.name);
+    sd_exp.name = NULL;
+  }
+  if (sdbuf) {
+    free(sdbuf);
+    sdbuf = NULL;
+  }
+  if (sdbuf_prev) {
+    free(sdbuf_prev);
+    sdbuf_prev = NULL;
+  }
+  if (sdbuf_rowinvalid) {
+    free(sdbuf_rowinvalid);
+    sdbuf_rowinvalid = NULL;
+  }
+  if (ordered_thr) {
+    free(ordered_thr);
+    ordered_thr = NULL;
   }
-  fp_serdisp_quit(dd);
+  if (ordered_line) {
+    free(ordered_line);
+    ordered_line = NULL;
+  }
+  dr_free();
+  fused_free();
+  sd_progfree(&sd_prog);
+  if (osd_layer) {
+    free(osd_layer);
+    osd_layer = NULL;
+  }
+  if (osd_layeralpha) {
+    free(osd_layeralpha);
+    osd_layeralpha = NULL;
+  }
+  if (osd_ovl) {
+    free(osd_ovl);
+    osd_ovl = NULL;
+  }
+  if (osd_ovlmask) {
+    free(osd_ovlmask);
+    osd_ovlmask = NULL;
+  }
+  if (osd_comp) {
+    free(osd_comp);
+    osd_comp = NULL;
+  }
+  if (osd_rotrow) {
+    free(osd_rotrow);
+    osd_rotrow = NULL;
+  }
+  if (fs_errinit) {
+    int t;
+
+    free(fs_errinit);
+    fs_errinit = NULL;
+    for (t = 0; t < SD_MAXTHREADS; t++) {
+      if (fs_err[t]) {
+        free(fs_err[t] - 1);
+        fs_err[t] = NULL;
+      }
+    }
+  }
+  if (stab_ref) {
+    free(stab_ref);
+    stab_ref = NULL;
+  }
+  if (stab_idx) {
+    free(stab_idx);
+    stab_idx = NULL;
+  }
+  if (sd_out.count)
+    sd_wallclose(&sd_out);
+  else if (dd)
+    fp_serdisp_quit(dd);
+  sd_out.dd = NULL;
 }
 
 
 
 static void
 draw_osd(void) {
-  int i,j, s;
-  int bar_width;
-  int bordergap = SD_OSD_BORDERGAP;
+  unsigned int start = GetTimer();
 
-  if (vo_osd_progbar_type != -1) {
-    bar_width = ((fp_serdisp_getwidth(dd) - 2 * bordergap  ) * vo_osd_progbar_value) / 255;
-    /* draw background using foreground colour */
-    for (j = osd_posy; j < osd_posy + osd_height; j++) {
-      for (i = 0; i < fp_serdisp_getwidth(dd); i++) {
-        fp_serdisp_setsdcol(dd, i,j, fg_colour);
-      }
-    }
-    /* draw progress-bar using background colour */
-    for (j = osd_posy + osd_margin ; j < osd_posy + osd_margin + osd_bar_height ; j++) {
-      for (i = 0 ; i < bar_width ; i++) {
-        fp_serdisp_setsdcol(dd, bordergap + i, j, bg_colour);
-      }
-      for (s = 0; s < 5; s++) {
-        i = bordergap +   (((fp_serdisp_getwidth(dd) - bordergap*2) / 4) * s);
-        if (!(s % 2) || (j % 2)) {
-          fp_serdisp_setsdcol(dd, i ,j, fp_serdisp_getsdcol(dd, i, j) ^ 0xFFFFFF);
-        }
-      }
-    }
-    osd_updated = 1; /* clean up remainders of osd */
+  if (frame_skip)
+    return;
+
+  /* rebuild the overlay only if the progress bar or the OSD text has changed */
+  if (vo_osd_changed(0) || vo_osd_progbar_type != osd_progbar_type ||
+      (vo_osd_progbar_type != -1 && vo_osd_progbar_value != osd_progbar_value)) {
+#if HAVE_PTHREADS
+    if (async_started)
+      pthread_mutex_lock(&async_mutex);
+#endif
+    osd_build(vo_osd_progbar_type, vo_osd_progbar_value);
+#if HAVE_PTHREADS
+    if (async_started)
+      pthread_mutex_unlock(&async_mutex);
+#endif
+  }
+
+  if (!serdisp_flag_async) {
+    if (osd_layergen != osd_ovlgen)
+      stage_add(STAGE_OSD, start);
+    osd_blit((istruecolour) ? tc_stage : sdbuf);
   }
+  /* asynchronous output: blitted by the display I/O thread after the frame has been output */
 }
 
 
@@ -873,11 +4266,72 @@ check_events(void) {
 }
 
 
+/* *********************************
+   set_equalizer(item, value) / get_equalizer(item, value)
+   *********************************
+   sets / gets an equalizer value. the tone curve is rebuilt immediately
+   *********************************
+   item   ... 'brightness', 'contrast' or 'gamma'
+   value  ... value in [-100, 100]
+   *********************************
+   --
+*/
+static int
+set_equalizer(const char* item, int value) {
+  int brightness = serdisp_eq_brightness, contrast = serdisp_eq_contrast;
+  double gamma = serdisp_flag_gamma;
+
+  if (value < -100) value = -100;
+  if (value >  100) value =  100;
+
+  if (!strcasecmp(item, "brightness")) {
+    serdisp_eq_brightness = value;
+  } else if (!strcasecmp(item, "contrast")) {
+    serdisp_eq_contrast = value;
+  } else if (!strcasecmp(item, "gamma")) {
+    /* [-100, 100] -> [1/8, 8] */
+    serdisp_flag_gamma = exp(log(8.0) * value / 100.0);
+  } else {
+    return VO_NOTIMPL;
+  }
+  tone_build();
+  if (brightness != serdisp_eq_brightness || contrast != serdisp_eq_contrast || gamma != serdisp_flag_gamma)
+    cache_eqchanged();
+  return VO_TRUE;
+}
+
+static int
+get_equalizer(const char* item, int* value) {
+  if (!strcasecmp(item, "brightness")) {
+    *value = serdisp_eq_brightness;
+  } else if (!strcasecmp(item, "contrast")) {
+    *value = serdisp_eq_contrast;
+  } else if (!strcasecmp(item, "gamma")) {
+    *value = (serdisp_flag_gamma > 0.0) ? (int)lrint(100.0 * log(serdisp_flag_gamma) / log(8.0)) : 0;
+  } else {
+    return VO_NOTIMPL;
+  }
+  return VO_TRUE;
+}
+
+
 static int
 control(uint32_t request, void *data) {
   switch (request) {
     case VOCTRL_QUERY_FORMAT:
       return query_format(*((uint32_t*)data));
+    case VOCTRL_GET_IMAGE:
+      return get_image(data);
+    case VOCTRL_DRAW_IMAGE:
+      return draw_image(data);
+    case VOCTRL_SET_EQUALIZER: {
+      vf_equalizer_t *eq = data;
+      return set_equalizer(eq->item, eq->value);
+    }
+    case VOCTRL_GET_EQUALIZER: {
+      vf_equalizer_t *eq = data;
+      return get_equalizer(eq->item, &eq->value);
+    }
   }
   return VO_NOTIMPL;
 }
@@ -0,0 +1,452 @@
+/*
+ * libserdisp_emu.c
+ * stand-in for serdisplib (libserdisp.so) to run the vo serdisp without display hardware
+ *
+ * implements every function the vo resolves using dlsym(). the display is emulated in memory: geometry and depth
+ * are given by the serdisplib options string and every display update is charged the time the bytes changed
+ * since the last update would need on a serial link at the baud rate given (8N1: 10 bits per byte).
+ * the last frame can be written to a PGM/PPM file, so complete mplayer runs can be compared headless.
+ *
+ * build:
+ *   gcc -O2 -shared -fPIC -o libserdisp.so tools/libserdisp_emu.c
+ * usage:
+ *   LD_LIBRARY_PATH=<dir of libserdisp.so> mplayer -vo 'serdisp:name=emu:options=width=240;height=128;depth=1;baud=115200' file
+ *
+ * options (serdisplib options string, separated by ';', names are case-insensitive):
+ *   width, height   geometry in native orientation (default: 128x64)
+ *   depth           bits per pixel: 1, 2, 4, 8 (greyscale), 12, 16, 24 (colour) (default: 1)
+ *   baud            emulated link speed in bits/s (0: updates take no time, default: 0)
+ *   rot             rotation in degrees: 0, 90, 180, 270 (serdisplib option ROTATE)
+ *   selfemitting    1: pixels set emit light (eg. OLED), background is black
+ *   stats           1: print updates, bytes transferred and link time to stderr when the display is closed
+ *   dump            file the last frame is written to when the display is closed (PGM / PPM)
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <time.h>
+
+#define EMU_VERSION_MAJOR  2
+#define EMU_VERSION_MINOR  2
+
+char sd_errormsg[255] = "";
+
+void serdisp_clear(void* dd);
+
+typedef struct {
+  int            width, height;          /* native orientation */
+  int            depth;
+  int            bpp;                    /* bytes per pixel in the frame buffer (depth >= 8) */
+  int            stride;                 /* bytes per row of the frame buffer */
+  long           baud;
+  int            rotate;                 /* ROTATE: 0: 0, 1: 180, 2: 90, 3: 270 degrees */
+  int            selfemitting;
+  int            stats;
+  char           dump[256];
+  unsigned char* fb;                     /* display content (native depth, packed msb first if depth < 8) */
+  unsigned char* sent;                   /* content transferred with the last update */
+  long           updates;
+  unsigned long long bytes;              /* bytes transferred */
+  double         linktime;               /* emulated link time (seconds) */
+} emu_t;
+
+
+/* *********************************
+   emu_charge(emu, bytes)
+   *********************************
+   waits for the time transferring the bytes would take on the emulated link
+   *********************************
+   --
+*/
+static void emu_charge(emu_t* emu, unsigned long bytes) {
+  double t;
+  struct timespec ts;
+
+  emu->bytes += bytes;
+  if (emu->baud <= 0 || !bytes)
+    return;
+  t = bytes * 10.0 / emu->baud;
+  emu->linktime += t;
+  ts.tv_sec = (time_t)t;
+  ts.tv_nsec = (long)((t - ts.tv_sec) * 1e9);
+  while (nanosleep(&ts, &ts))
+    ;
+}
+
+
+/* *********************************
+   emu_map(emu, x, y, px, py)
+   *********************************
+   maps a position (rotated as set by ROTATE) to native orientation
+   *********************************
+   returns 0 if the position is inside the display, else -1
+   *********************************
+   --
+*/
+static int emu_map(emu_t* emu, int x, int y, int* px, int* py) {
+  switch (emu->rotate) {
+    case 1:  *px = emu->width - 1 - x;  *py = emu->height - 1 - y; break;
+    case 2:  *px = emu->width - 1 - y;  *py = x;                   break;
+    case 3:  *px = y;                   *py = emu->height - 1 - x; break;
+    default: *px = x;                   *py = y;
+  }
+  return (*px < 0 || *py < 0 || *px >= emu->width || *py >= emu->height) ? -1 : 0;
+}
+
+
+/* *********************************
+   emu_set(emu, x, y, colour) / emu_get(emu, x, y)
+   *********************************
+   stores / reads a pixel (0xAARRGGBB) at a native position. greyscale: the luminance is quantised to the depth
+   *********************************
+   --
+*/
+static void emu_set(emu_t* emu, int x, int y, uint32_t colour) {
+  int r = (colour >> 16) & 0xFF, g = (colour >> 8) & 0xFF, b = colour & 0xFF;
+  unsigned char* p;
+
+  if (emu->depth < 8) {
+    int max = (1 << emu->depth) - 1;
+    int idx = (((r * 77 + g * 150 + b * 29) >> 8) * max + 127) / 255;
+    int shift = (8 - emu->depth) - (x * emu->depth & 7);
+
+    p = emu->fb + y * emu->stride + (x * emu->depth >> 3);
+    *p = (*p & ~(max << shift)) | (idx << shift);
+    return;
+  }
+  p = emu->fb + y * emu->stride + x * emu->bpp;
+  switch (emu->depth) {
+    case 8:  p[0] = (r * 77 + g * 150 + b * 29) >> 8; break;
+    case 12: p[0] = r >> 4; p[1] = (g & 0xF0) | (b >> 4); break;
+    case 16: p[0] = (r & 0xF8) | (g >> 5); p[1] = ((g << 3) & 0xE0) | (b >> 3); break;
+    default: p[0] = r; p[1] = g; p[2] = b;
+  }
+}
+
+static uint32_t emu_get(emu_t* emu, int x, int y) {
+  unsigned char* p;
+  int r, g, b;
+
+  if (emu->depth < 8) {
+    int max = (1 << emu->depth) - 1;
+    int shift = (8 - emu->depth) - (x * emu->depth & 7);
+
+    g = ((emu->fb[y * emu->stride + (x * emu->depth >> 3)] >> shift) & max) * 255 / max;
+    return 0xFF000000 | (g << 16) | (g << 8) | g;
+  }
+  p = emu->fb + y * emu->stride + x * emu->bpp;
+  switch (emu->depth) {
+    case 8:  r = g = b = p[0]; break;
+    case 12: r = p[0] * 17; g = (p[1] >> 4) * 17; b = (p[1] & 0x0F) * 17; break;
+    case 16: r = p[0] & 0xF8; g = ((p[0] << 5) | (p[1] >> 3)) & 0xFC; b = (p[1] << 3) & 0xF8; break;
+    default: r = p[0]; g = p[1]; b = p[2];
+  }
+  return 0xFF000000 | (r << 16) | (g << 8) | b;
+}
+
+
+/* *********************************
+   emu_option(emu, name, value)
+   *********************************
+   sets an option of the options string
+   *********************************
+   returns 0 if ok, else -1
+   *********************************
+   --
+*/
+static int emu_option(emu_t* emu, const char* name, const char* value) {
+  if (!strcasecmp(name, "width")) {
+    emu->width = atoi(value);
+  } else if (!strcasecmp(name, "height")) {
+    emu->height = atoi(value);
+  } else if (!strcasecmp(name, "depth")) {
+    emu->depth = atoi(value);
+  } else if (!strcasecmp(name, "baud")) {
+    emu->baud = atol(value);
+  } else if (!strcasecmp(name, "rot") || !strcasecmp(name, "rotate")) {
+    switch (atoi(value)) {
+      case 180: emu->rotate = 1; break;
+      case 90:  emu->rotate = 2; break;
+      case 270: emu->rotate = 3; break;
+      default:  emu->rotate = 0;
+    }
+  } else if (!strcasecmp(name, "selfemitting")) {
+    emu->selfemitting = atoi(value);
+  } else if (!strcasecmp(name, "stats")) {
+    emu->stats = atoi(value);
+  } else if (!strcasecmp(name, "dump")) {
+    snprintf(emu->dump, sizeof(emu->dump), "%s", value);
+  } else if (strcasecmp(name, "brightness") && strcasecmp(name, "contrast") && strcasecmp(name, "invert") &&
+             strcasecmp(name, "backlight")) {
+    return -1;
+  }
+  return 0;
+}
+
+
+/* *********************************
+   emu_dump(emu)
+   *********************************
+   writes the display content (native orientation) to the dump file
+   *********************************
+   --
+*/
+static void emu_dump(emu_t* emu) {
+  FILE* f = fopen(emu->dump, "wb");
+  int x, y, grey = (emu->depth <= 8);
+
+  if (!f) {
+    fprintf(stderr, "libserdisp_emu: unable to write %s\n", emu->dump);
+    return;
+  }
+  fprintf(f, "%s\n%d %d\n255\n", (grey) ? "P5" : "P6", emu->width, emu->height);
+  for (y = 0; y < emu->height; y++) {
+    for (x = 0; x < emu->width; x++) {
+      uint32_t c = emu_get(emu, x, y);
+
+      if (grey) {
+        fputc(c & 0xFF, f);
+      } else {
+        fputc((c >> 16) & 0xFF, f);
+        fputc((c >> 8) & 0xFF, f);
+        fputc(c & 0xFF, f);
+      }
+    }
+  }
+  fclose(f);
+}
+
+
+long serdisp_getversioncode(void) {
+  return (EMU_VERSION_MAJOR << 8) + EMU_VERSION_MINOR;
+}
+
+char* serdisp_defaultdevice(const char* dispname) {
+  return "EMU";
+}
+
+void* SDCONN_open(const char* sdcddev) {
+  static int sdcd;   /* connection descriptor: never dereferenced by the vo */
+
+  return &sdcd;
+}
+
+void* serdisp_init(void* sdcd, const char* dispname, const char* extra) {
+  emu_t* emu = (emu_t*)calloc(1, sizeof(emu_t));
+  char* opts = strdup((extra) ? extra : "");
+  char* entry;
+  char* next;
+
+  if (!emu || !opts) {
+    free(emu);
+    free(opts);
+    snprintf(sd_errormsg, sizeof(sd_errormsg), "out of memory");
+    return NULL;
+  }
+  emu->width = 128;
+  emu->height = 64;
+  emu->depth = 1;
+  for (entry = opts; entry; entry = next) {
+    char* value;
+
+    if ((next = strchr(entry, ';')))
+      *next++ = '\0';
+    if (!*entry)
+      continue;
+    value = strchr(entry, '=');
+    if (value)
+      *value++ = '\0';
+    if (emu_option(emu, entry, (value) ? value : "1")) {
+      snprintf(sd_errormsg, sizeof(sd_errormsg), "unknown option %s", entry);
+      free(opts);
+      free(emu);
+      return NULL;
+    }
+  }
+  free(opts);
+
+  if (emu->width < 1 || emu->height < 1 || emu->width > 8192 || emu->height > 8192 ||
+      (emu->depth != 1 && emu->depth != 2 && emu->depth != 4 && emu->depth != 8 &&
+       emu->depth != 12 && emu->depth != 16 && emu->depth != 24)) {
+    snprintf(sd_errormsg, sizeof(sd_errormsg), "invalid geometry %dx%d, depth %d", emu->width, emu->height, emu->depth);
+    free(emu);
+    return NULL;
+  }
+  emu->bpp = (emu->depth < 8) ? 0 : (emu->depth + 7) >> 3;
+  emu->stride = (emu->depth < 8) ? (emu->width * emu->depth + 7) >> 3 : emu->width * emu->bpp;
+  emu->fb = (unsigned char*)malloc(emu->stride * emu->height);
+  emu->sent = (unsigned char*)malloc(emu->stride * emu->height);
+  if (!emu->fb || !emu->sent) {
+    free(emu->fb);
+    free(emu->sent);
+    free(emu);
+    snprintf(sd_errormsg, sizeof(sd_errormsg), "out of memory");
+    return NULL;
+  }
+  serdisp_clear(emu);
+  return emu;
+}
+
+void serdisp_quit(void* dd) {
+  emu_t* emu = (emu_t*)dd;
+
+  if (!emu)
+    return;
+  if (emu->stats)
+    fprintf(stderr, "libserdisp_emu: %dx%dx%d: %ld updates, %llu bytes transferred, link time %.3f s\n",
+                    emu->width, emu->height, emu->depth, emu->updates, emu->bytes, emu->linktime);
+  if (emu->dump[0])
+    emu_dump(emu);
+  free(emu->fb);
+  free(emu->sent);
+  free(emu);
+}
+
+int serdisp_isoption(void* dd, const char* optionname) {
+  return !strcasecmp(optionname, "ROTATE") || !strcasecmp(optionname, "SELFEMITTING") ||
+         !strcasecmp(optionname, "BACKLIGHT") || !strcasecmp(optionname, "INVERT");
+}
+
+void serdisp_setoption(void* dd, const char* optionname, long value) {
+  emu_t* emu = (emu_t*)dd;
+
+  if (!strcasecmp(optionname, "ROTATE"))
+    emu->rotate = (int)(value & 3);
+}
+
+long serdisp_getoption(void* dd, const char* optionname, int* typesize) {
+  emu_t* emu = (emu_t*)dd;
+
+  if (typesize)
+    *typesize = sizeof(long);
+  if (!strcasecmp(optionname, "ROTATE"))
+    return emu->rotate;
+  if (!strcasecmp(optionname, "SELFEMITTING"))
+    return emu->selfemitting;
+  return 0;
+}
+
+int serdisp_getwidth(void* dd) {
+  emu_t* emu = (emu_t*)dd;
+
+  return (emu->rotate & 2) ? emu->height : emu->width;
+}
+
+int serdisp_getheight(void* dd) {
+  emu_t* emu = (emu_t*)dd;
+
+  return (emu->rotate & 2) ? emu->width : emu->height;
+}
+
+int serdisp_getcolours(void* dd) {
+  emu_t* emu = (emu_t*)dd;
+
+  return (emu->depth >= 24) ? 0x1000000 : 1 << emu->depth;
+}
+
+int serdisp_getdepth(void* dd) {
+  return ((emu_t*)dd)->depth;
+}
+
+int serdisp_getpixelaspect(void* dd) {
+  return 100;
+}
+
+void serdisp_setsdcol(void* dd, int x, int y, uint32_t colour) {
+  emu_t* emu = (emu_t*)dd;
+  int px, py;
+
+  if (!emu_map(emu, x, y, &px, &py))
+    emu_set(emu, px, py, colour);
+}
+
+void serdisp_setsdgrey(void* dd, int x, int y, unsigned char grey) {
+  serdisp_setsdcol(dd, x, y, 0xFF000000 | (grey << 16) | (grey << 8) | grey);
+}
+
+uint32_t serdisp_getsdcol(void* dd, int x, int y) {
+  emu_t* emu = (emu_t*)dd;
+  int px, py;
+
+  return (emu_map(emu, x, y, &px, &py)) ? 0 : emu_get(emu, px, py);
+}
+
+/* content: inpmode 1, 2, 4: packed grey indices (msb first), 8: grey, 16: rgb565 (native endianness), 24: rgb */
+int serdisp_cliparea(void* dd, int x, int y, int w, int h, int sx, int sy, int cw, int ch, int inpmode,
+                     unsigned char* content) {
+  int i, j;
+
+  if (x < 0 || y < 0 || w < 0 || h < 0 || x + w > serdisp_getwidth(dd) || y + h > serdisp_getheight(dd) ||
+      sx < 0 || sy < 0 || sx + w > cw || sy + h > ch)
+    return 0;
+
+  for (j = 0; j < h; j++) {
+    for (i = 0; i < w; i++) {
+      int cx = sx + i, cy = sy + j;
+      uint32_t colour;
+
+      if (inpmode < 8) {
+        int stride = (cw * inpmode + 7) >> 3, max = (1 << inpmode) - 1;
+        int shift = (8 - inpmode) - (cx * inpmode & 7);
+        int g = ((content[cy * stride + (cx * inpmode >> 3)] >> shift) & max) * 255 / max;
+
+        colour = 0xFF000000 | (g << 16) | (g << 8) | g;
+      } else if (inpmode == 8) {
+        int g = content[cy * cw + cx];
+
+        colour = 0xFF000000 | (g << 16) | (g << 8) | g;
+      } else if (inpmode == 16) {
+        uint16_t v = ((uint16_t*)content)[cy * cw + cx];
+
+        colour = 0xFF000000 | (((v >> 11) & 0x1F) << 19) | (((v >> 5) & 0x3F) << 10) | ((v & 0x1F) << 3);
+      } else {
+        unsigned char* p = content + (cy * cw + cx) * 3;
+
+        colour = 0xFF000000 | (p[0] << 16) | (p[1] << 8) | p[2];
+      }
+      serdisp_setsdcol(dd, x + i, y + j, colour);
+    }
+  }
+  return 1;
+}
+
+/* transfers the bytes changed since the last update */
+void serdisp_update(void* dd) {
+  emu_t* emu = (emu_t*)dd;
+  unsigned long changed = 0;
+  int i, n = emu->stride * emu->height;
+
+  for (i = 0; i < n; i++)
+    changed += (emu->fb[i] != emu->sent[i]);
+  memcpy(emu->sent, emu->fb, n);
+  if (emu->depth == 12)
+    changed = (changed * 3 + 3) / 4;   /* 12 bits stored in two bytes */
+  emu->updates++;
+  emu_charge(emu, changed);
+}
+
+/* transfers the whole display content */
+void serdisp_rewrite(void* dd) {
+  emu_t* emu = (emu_t*)dd;
+
+  memcpy(emu->sent, emu->fb, emu->stride * emu->height);
+  emu->updates++;
+  emu_charge(emu, (emu->depth == 12) ? (emu->width * emu->height * 3 + 1) / 2 : emu->stride * emu->height);
+}
+
+void serdisp_clear(void* dd) {
+  emu_t* emu = (emu_t*)dd;
+  int x, y;
+
+  for (y = 0; y < emu->height; y++)
+    for (x = 0; x < emu->width; x++)
+      emu_set(emu, x, y, (emu->selfemitting) ? 0xFF000000 : 0xFFFFFFFF);
+  serdisp_rewrite(emu);
+}
@@ -0,0 +1,86 @@
+#!/bin/sh
+#
+# sdbench.sh
+# benchmark of the drawing routines of the vo serdisp at typical panel sizes
+#
+# runs mplayer (patched using vo_serdisp.patch) with option 'benchmark' against the emulated serdisplib
+# (tools/libserdisp_emu.c, built on the fly) for every panel size and depth and prints ns/pixel and frames/s of the
+# drawing routine selected. if perf is available, cache misses per frame are printed as well: the misses of a run
+# without benchmark frames are subtracted, so decoding, scaling and setup are not counted.
+# the video is a synthetic one (raw i420 from /dev/zero) in panel geometry, the benchmark draws its own frames.
+#
+# usage:
+#   tools/sdbench.sh [vo suboptions]
+#   eg. tools/sdbench.sh dither=2:threads=2
+#
+# environment:
+#   MPLAYER  ... mplayer binary (default: mplayer)
+#   FRAMES   ... benchmark frames per run (default: 200)
+#   SIZES    ... panel sizes (default: "128x64 240x128 320x240 1024x768")
+#   DEPTHS   ... display depths (default: "1 2 4 16")
+#   CC       ... C compiler (default: cc)
+#
+
+MPLAYER=${MPLAYER:-mplayer}
+FRAMES=${FRAMES:-200}
+SIZES=${SIZES:-"128x64 240x128 320x240 1024x768"}
+DEPTHS=${DEPTHS:-"1 2 4 16"}
+SUBOPTS=${1:+:$1}
+
+dir=$(cd "$(dirname "$0")" && pwd)
+tmp=$(mktemp -d) || exit 1
+trap 'rm -rf "$tmp"' EXIT INT TERM
+
+if ! ${CC:-cc} -O2 -shared -fPIC -o "$tmp/libserdisp.so" "$dir/libserdisp_emu.c"; then
+  echo "sdbench: unable to build the emulated serdisplib" >&2
+  exit 1
+fi
+
+# cache misses: only if perf may count them
+perf=0
+if command -v perf >/dev/null 2>&1 && perf stat -x, -e cache-misses -o "$tmp/perf" true 2>/dev/null &&
+   ! grep -q "not supported\|not counted" "$tmp/perf"; then
+  perf=1
+fi
+
+# run(size, depth, frames): runs mplayer, output in $tmp/out, cache misses in $tmp/perf
+run() {
+  w=${1%x*}
+  h=${1#*x}
+  set -- -nosound -noconsolecontrols -nolirc -msglevel all=1:vo=4 -frames 1 \
+         -demuxer rawvideo -rawvideo "w=$w:h=$h:format=i420" \
+         -vo "serdisp:name=emu:options=width=$w;height=$h;depth=$2:benchmark=$3$SUBOPTS" /dev/zero
+  if [ $perf -eq 1 ]; then
+    LD_LIBRARY_PATH="$tmp" perf stat -x, -e cache-misses -o "$tmp/perf" "$MPLAYER" "$@" > "$tmp/out" 2>&1
+  else
+    LD_LIBRARY_PATH="$tmp" "$MPLAYER" "$@" > "$tmp/out" 2>&1
+  fi
+}
+
+misses() {
+  awk -F, '$3 ~ /^cache-misses/ { print $1 + 0 }' "$tmp/perf"
+}
+
+printf "%-10s %5s %12s %12s %16s\n" "panel" "depth" "ns/pixel" "frames/s" "misses/frame"
+for size in $SIZES; do
+  for depth in $DEPTHS; do
+    missesframe="n/a"
+    if [ $perf -eq 1 ]; then
+      run "$size" "$depth" 0
+      base=$(misses)
+    fi
+    run "$size" "$depth" "$FRAMES"
+    line=$(grep "benchmark: .* ns/pixel" "$tmp/out")
+    if [ -z "$line" ]; then
+      echo "sdbench: $size depth $depth: no benchmark result, mplayer output:" >&2
+      cat "$tmp/out" >&2
+      continue
+    fi
+    nspixel=$(echo "$line" | sed 's/.*drawing: \([0-9.]*\) ns\/pixel.*/\1/')
+    fps=$(echo "$line" | sed 's/.*ns\/pixel, \([0-9.]*\) frames\/s.*/\1/')
+    if [ $perf -eq 1 ]; then
+      missesframe=$(awk -v a="$(misses)" -v b="$base" -v f="$FRAMES" 'BEGIN { m = (a - b) / f; printf "%.0f", (m > 0) ? m : 0 }')
+    fi
+    printf "%-10s %5s %12s %12s %16s\n" "$size" "$depth" "$nspixel" "$fps" "$missesframe"
+  done
+done
@@ -0,0 +1,115 @@
+/*
+ * sdorderedcheck.c
+ * check of the ordered dithering of the vo serdisp (libvo/serdisp_ordered.c)
+ *
+ * for every threshold matrix (bayer 4x4, bayer 8x8, blue noise 32x32), every number of colours (2 - 256) and every
+ * quantisation kernel available on this cpu: black (0) has to be quantised to index 0 and white (255) to the last
+ * index for every threshold, and the SIMD kernels have to return the same indices as the C kernel for all grey values.
+ *
+ * build (in the mplayer source directory after configure, config.h is needed):
+ *   gcc -O2 -I. -o sdorderedcheck /path/to/tools/sdorderedcheck.c libvo/serdisp_ordered.c -lm
+ * usage:
+ *   sdorderedcheck
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libvo/serdisp_ordered.h"
+
+#define ROW   (SD_ORDERED_MAXSIZE * 8 + 3)   /* several tiles and a tail not handled by the SIMD loops */
+
+typedef void (*quantise_t) (unsigned char* idx, const unsigned char* grey, const unsigned char* thr, int w, int levels);
+
+static const struct {
+  const char* name;
+  int         size;
+  int         bluenoise;
+} matrices[] = {
+  { "bayer 4x4",        4,                  0 },
+  { "bayer 8x8",        8,                  0 },
+  { "blue noise 32x32", SD_ORDERED_MAXSIZE, 1 },
+};
+
+
+/* *********************************
+   check_row(name, kernel, thr, levels)
+   *********************************
+   quantises black, white and every grey value using one row of thresholds
+   *********************************
+   returns the number of errors
+   *********************************
+   --
+*/
+static int check_row(const char* name, quantise_t kernel, const unsigned char* thr, int levels) {
+  unsigned char grey[ROW], idx[ROW], ref[ROW];
+  int x, g, errors = 0;
+
+  memset(grey, 0, ROW);
+  kernel(idx, grey, thr, ROW, levels);
+  for (x = 0; x < ROW; x++)
+    if (idx[x] != 0 && errors++ < 4)
+      printf("  %s, %d colours: black -> %d (threshold %d)\n", name, levels + 1, idx[x], thr[x]);
+
+  memset(grey, 255, ROW);
+  kernel(idx, grey, thr, ROW, levels);
+  for (x = 0; x < ROW; x++)
+    if (idx[x] != levels && errors++ < 4)
+      printf("  %s, %d colours: white -> %d (threshold %d)\n", name, levels + 1, idx[x], thr[x]);
+
+  for (g = 0; g < 256; g++) {
+    memset(grey, g, ROW);
+    sd_orderedquantise_c(ref, grey, thr, ROW, levels);
+    kernel(idx, grey, thr, ROW, levels);
+    if (memcmp(ref, idx, ROW) && errors++ < 4)
+      printf("  %s, %d colours: grey %d differs from the C kernel\n", name, levels + 1, g);
+  }
+  return errors;
+}
+
+
+int main(void) {
+  struct { const char* name; quantise_t kernel; } kernels[3];
+  int rank[SD_ORDERED_MAXSIZE * SD_ORDERED_MAXSIZE];
+  unsigned char thr[ROW];
+  int nkernels = 0, m, k, y, x, levels, errors = 0;
+
+  kernels[nkernels].name = "C";
+  kernels[nkernels++].kernel = sd_orderedquantise_c;
+#ifdef SD_ORDERED_SSE2
+  if (__builtin_cpu_supports("sse2")) {
+    kernels[nkernels].name = "SSE2";
+    kernels[nkernels++].kernel = sd_orderedquantise_sse2;
+  }
+#endif
+#if HAVE_NEON
+  kernels[nkernels].name = "NEON";
+  kernels[nkernels++].kernel = sd_orderedquantise_neon;
+#endif
+
+  for (m = 0; m < (int)(sizeof(matrices) / sizeof(matrices[0])); m++) {
+    int n = matrices[m].size, merrors = 0;
+
+    if (matrices[m].bluenoise)
+      sd_orderedbluenoise(rank, n);
+    else
+      sd_orderedbayer(rank, n);
+
+    for (k = 0; k < nkernels; k++) {
+      for (y = 0; y < n; y++) {
+        for (x = 0; x < ROW; x++)
+          thr[x] = SD_ORDERED_THR(rank[y * n + (x % n)], n);
+        for (levels = 1; levels <= 255; levels++)
+          merrors += check_row(kernels[k].name, kernels[k].kernel, thr, levels);
+      }
+    }
+    printf("sdorderedcheck: %-16s %d kernel(s), 2 - 256 colours: %s\n", matrices[m].name, nkernels,
+           (merrors) ? "FAILED" : "ok");
+    errors += merrors;
+  }
+  return (errors) ? 1 : 0;
+}
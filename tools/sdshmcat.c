@@ -0,0 +1,203 @@
+/*
+ * sdshmcat.c
+ * consumer of the frame export of the vo serdisp (option 'shm')
+ *
+ * waits for the shared memory object, follows the frames published (reading them in place as described in
+ * README.md, section 'Frame export') until playback has ended and prints the number of frames read, frames
+ * missed (overwritten before they were read) and torn reads (slot rewritten while it was read).
+ * the last frame can be written to a PGM/PPM file.
+ *
+ * build:
+ *   gcc -O2 -o sdshmcat tools/sdshmcat.c -lrt
+ * usage:
+ *   sdshmcat <name> [file]
+ *   eg. sdshmcat /serdisp last.pgm & mplayer -vo 'serdisp:shm=/serdisp:shmgeometry=128x64x1' file
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SD_SHM_MAGIC  "SDSHM001"
+#define SD_SHM_WAIT   5000                  /* ms to wait for the object to be created */
+
+/* layout as exported by libvo/serdisp_export.c (export_header_t, export_slot_t) */
+typedef struct {
+  char              magic[8];
+  uint32_t          headersize;
+  uint32_t          slots;
+  uint32_t          slotsize;
+  uint32_t          width, height;
+  uint32_t          depth;
+  uint32_t          colours;
+  uint32_t          stride;
+  uint32_t          pid;
+  volatile uint32_t active;
+  volatile uint32_t seq;
+} shm_header_t;
+
+typedef struct {
+  volatile uint32_t seq;
+  uint32_t          reserved;
+  double            time;
+} shm_slot_t;
+
+
+/* *********************************
+   shm_attach(name, size)
+   *********************************
+   waits for the shared memory object and its header to be complete and maps it read-only
+   *********************************
+   name   ... name of the shared memory object
+   size   ... returns the size of the mapping
+   *********************************
+   shm_attach() returns the header or NULL if the object could not be mapped
+   *********************************
+   --
+*/
+static shm_header_t* shm_attach(const char* name, size_t* size) {
+  shm_header_t* hdr;
+  struct stat st;
+  int fd = -1, i;
+
+  for (i = 0; i < SD_SHM_WAIT / 10 && (fd = shm_open(name, O_RDONLY, 0)) < 0; i++)
+    usleep(10000);
+  if (fd < 0) {
+    perror("sdshmcat: shm_open");
+    return NULL;
+  }
+  /* the producer creates the object before it is resized */
+  for (i = 0; i < SD_SHM_WAIT && fstat(fd, &st) == 0 && (size_t)st.st_size < sizeof(shm_header_t); i++)
+    usleep(1000);
+  if ((size_t)st.st_size < sizeof(shm_header_t) ||
+      (hdr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+    fprintf(stderr, "sdshmcat: unable to map %s\n", name);
+    close(fd);
+    return NULL;
+  }
+  close(fd);
+  for (i = 0; i < SD_SHM_WAIT && memcmp(hdr->magic, SD_SHM_MAGIC, 8); i++)
+    usleep(1000);
+  __sync_synchronize();
+  if (memcmp(hdr->magic, SD_SHM_MAGIC, 8) ||
+      (size_t)hdr->headersize + (size_t)hdr->slots * hdr->slotsize > (size_t)st.st_size) {
+    fprintf(stderr, "sdshmcat: %s is no frame export\n", name);
+    munmap(hdr, st.st_size);
+    return NULL;
+  }
+  *size = st.st_size;
+  return hdr;
+}
+
+
+/* *********************************
+   shm_dump(hdr, frame, file)
+   *********************************
+   writes a frame to a PGM (depth <= 8) or PPM file
+   *********************************
+   --
+*/
+static void shm_dump(const shm_header_t* hdr, const unsigned char* frame, const char* file) {
+  FILE* f = fopen(file, "wb");
+  uint32_t x, y;
+  int grey = (hdr->depth <= 8);
+
+  if (!f) {
+    fprintf(stderr, "sdshmcat: unable to write %s\n", file);
+    return;
+  }
+  fprintf(f, "%s\n%u %u\n255\n", (grey) ? "P5" : "P6", hdr->width, hdr->height);
+  for (y = 0; y < hdr->height; y++) {
+    const unsigned char* row = frame + y * hdr->stride;
+
+    for (x = 0; x < hdr->width; x++) {
+      if (grey) {
+        int ppb = 8 / hdr->depth;
+        int idx = (row[x / ppb] >> ((ppb - 1 - x % ppb) * hdr->depth)) & ((1 << hdr->depth) - 1);
+
+        fputc((hdr->colours > 1) ? idx * 255 / (hdr->colours - 1) : 0, f);
+      } else if (hdr->depth == 16) {
+        uint16_t v = ((const uint16_t*)row)[x];
+
+        fputc(((v >> 11) & 0x1F) << 3, f);
+        fputc(((v >> 5) & 0x3F) << 2, f);
+        fputc((v & 0x1F) << 3, f);
+      } else {
+        fwrite(row + x * 3, 1, 3, f);
+      }
+    }
+  }
+  fclose(f);
+}
+
+
+int main(int argc, char** argv) {
+  shm_header_t* hdr;
+  unsigned char* frame;
+  size_t size, framesize;
+  uint32_t last = 0;
+  long frames = 0, missed = 0, torn = 0;
+  double time = 0.0;
+
+  if (argc < 2) {
+    fprintf(stderr, "usage: sdshmcat <name> [file]\n");
+    return 1;
+  }
+  if (!(hdr = shm_attach(argv[1], &size)))
+    return 1;
+
+  fprintf(stderr, "sdshmcat: %ux%u, depth %u, %u colours, %u slots\n",
+          hdr->width, hdr->height, hdr->depth, hdr->colours, hdr->slots);
+  framesize = (size_t)hdr->stride * hdr->height;
+  if (!(frame = malloc(framesize)))
+    return 1;
+
+  for (;;) {
+    uint32_t seq = hdr->seq;
+
+    if (seq && seq != last) {
+      const shm_slot_t* slot = (const shm_slot_t*)((const unsigned char*)hdr + hdr->headersize +
+                                                   (seq % hdr->slots) * hdr->slotsize);
+      double t;
+
+      if (slot->seq != seq) {   /* already being rewritten */
+        torn++;
+        continue;
+      }
+      __sync_synchronize();
+      memcpy(frame, slot + 1, framesize);
+      t = slot->time;
+      __sync_synchronize();
+      if (slot->seq != seq) {
+        torn++;
+        continue;
+      }
+      if (last && seq > last + 1)
+        missed += seq - last - 1;
+      last = seq;
+      time = t;
+      frames++;
+    } else if (!hdr->active) {
+      break;
+    } else {
+      usleep(200);
+    }
+  }
+
+  fprintf(stderr, "sdshmcat: %ld frames read, %ld missed, %ld torn reads, last frame %u at %.3f s\n",
+          frames, missed, torn, last, time);
+  if (argc > 2 && frames)
+    shm_dump(hdr, frame, argv[2]);
+  free(frame);
+  munmap(hdr, size);
+  return 0;
+}